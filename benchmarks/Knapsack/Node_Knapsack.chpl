@@ -8,6 +8,7 @@ module Node_Knapsack
     var items: maxItems*uint(32);
     var weight: int;
     var profit: int;
+    var bound: int; // upper bound
 
     // default-initializer
     proc init()
@@ -16,6 +17,7 @@ module Node_Knapsack
     // root-initializer
     proc init(problem)
     {
+      this.bound = max(int); // not computed, the root is never pruned
       init this;
     }
 
@@ -26,9 +28,7 @@ module Node_Knapsack
       this.items = other.items;
       this.weight = other.weight;
       this.profit = other.profit;
+      this.bound = other.bound;
     }
-
-    proc deinit()
-    {}
   }
 }
@@ -1,10 +1,10 @@
 module Problem_Knapsack
 {
   use CTypes;
-  use List;
   use Path;
 
   use Problem;
+  use Incumbent;
   use Instances;
 
   require "../../commons/c_sources/util.c", "../../commons/c_headers/util.h";
@@ -12,8 +12,29 @@ module Problem_Knapsack
 
   const allowedUpperBounds = ["dantzig", "martello"];
 
+  // Identifiers of the upper bounds (indices in the array above)
+  param DANTZIG = 0, MARTELLO = 1;
+
+  /*
+    Check the upper bound given by name, and return its identifier, which
+    parameterizes `Problem_Knapsack`.
+  */
+  proc upperBoundId(const ub: string): int
+  {
+    const ubId = allowedUpperBounds.find(ub);
+    if (ubId == -1) then halt("Error - Unsupported upper bound");
+
+    return ubId;
+  }
+
+  /*
+    The upper bound `ubId` is a compile-time parameter, so that the decomposition
+    is specialized for it.
+  */
   class Problem_Knapsack : Problem
   {
+    param ubId: int;
+
     var name: string;          // instance name
     var N: c_int;              // number of items
     var W: c_longlong;         // maximum weight of the bag
@@ -26,9 +47,11 @@ module Problem_Knapsack
     var initLB: int;
 
     // initialisation
-    proc init(const fileName: string, const n, const r, const t, const id, const s,
-      const ub: string, const lb: string): void
+    proc init(param ubId: int, const fileName: string, const n, const r, const t, const id,
+      const s, const lb: string): void
     {
+      this.ubId = ubId;
+
       // TODO: Is id > s allowed?
 
       var inst = new Instance();
@@ -43,8 +66,7 @@ module Problem_Knapsack
       inst.get_profits(this.profits);
       inst.get_weights(this.weights);
 
-      if (allowedUpperBounds.find(ub) != -1) then this.ub_name = ub;
-      else halt("Error - Unsupported upper bound");
+      this.ub_name = allowedUpperBounds[ubId];
 
       this.lb_init = lb;
 
@@ -72,21 +94,23 @@ module Problem_Knapsack
     }
 
     // copy-initialisation
-    proc init(const file_name: string, const n, const w, const pr: c_ptr(c_int),
+    proc init(param ubId: int, const file_name: string, const n, const w, const pr: c_ptr(c_int),
       const we: c_ptr(c_int), const lb: string, const init_lb: int): void
     {
+      this.ubId    = ubId;
       this.name    = file_name;
       this.N       = n;
       this.W       = w;
       this.profits = pr;
       this.weights = we;
+      this.ub_name = allowedUpperBounds[ubId];
       this.lb_init = lb;
       this.initLB  = init_lb;
     }
 
     override proc copy()
     {
-      return new Problem_Knapsack(this.name, this.N, this.W, this.profits, this.weights,
+      return new Problem_Knapsack(ubId, this.name, this.N, this.W, this.profits, this.weights,
         this.lb_init, this.initLB);
     }
 
@@ -110,11 +134,9 @@ module Problem_Knapsack
       return floor(bound);
     }
 
-    proc decompose_dantzig(type Node, const parent: Node, ref tree_loc: int, ref num_sol: int,
-      ref max_depth: int, ref best: int, lock: sync bool, ref best_task: int): list(?)
+    proc decompose_dantzig(type Node, const parent: Node, ref children, ref tree_loc: int,
+      ref num_sol: int, ref max_depth: int, ref best_task: int, incumbent: borrowed Incumbent): void
     {
-      var children: list(Node);
-
       for i in 0..1 {
         var child = new Node(parent);
         child.depth += 1;
@@ -126,31 +148,28 @@ module Problem_Knapsack
           if (child.depth == this.N) { // leaf
             if (best_task < child.profit) {
               best_task = child.profit;
-              lock.readFE();
-              if best <= child.profit {
-                best = child.profit;
+              if incumbent.update(child.profit) {
                 num_sol = 1;
               }
               else {
-                best_task = best;
+                best_task = incumbent.read();
                 num_sol = 0;
               }
-              lock.writeEF(true);
             }
             else if (best_task == child.profit) {
               num_sol += 1;
             }
           }
           else {
-            if (best_task <= bound_dantzig(Node, child)) { // bounding and pruning
+            const bound = bound_dantzig(Node, child):int;
+            if (best_task <= bound) { // bounding and pruning
+              child.bound = bound;
               children.pushBack(child);
               tree_loc += 1;
             }
           }
         }
       }
-
-      return children;
     }
 
     // Bound from Martello and Toth (1977)
@@ -184,11 +203,9 @@ module Problem_Knapsack
       return max(floor(U0), floor(U1));
     }
 
-    proc decompose_martello(type Node, const parent: Node, ref tree_loc: int, ref num_sol: int,
-      ref max_depth: int, ref best: int, lock: sync bool, ref best_task: int): list(?)
+    proc decompose_martello(type Node, const parent: Node, ref children, ref tree_loc: int,
+      ref num_sol: int, ref max_depth: int, ref best_task: int, incumbent: borrowed Incumbent): void
     {
-      var children: list(Node);
-
       for i in 0..1 {
         var child = new Node(parent);
         child.depth += 1;
@@ -200,47 +217,39 @@ module Problem_Knapsack
           if (child.depth == this.N) { // leaf
             if (best_task < child.profit) {
               best_task = child.profit;
-              lock.readFE();
-              if best <= child.profit {
-                best = child.profit;
+              if incumbent.update(child.profit) {
                 num_sol = 1;
               }
               else {
-                best_task = best;
+                best_task = incumbent.read();
                 num_sol = 0;
               }
-              lock.writeEF(true);
             }
             else if (best_task == child.profit) {
               num_sol += 1;
             }
           }
           else {
-            if (best_task <= bound_martello(Node, child)) { // bounding and pruning
+            const bound = bound_martello(Node, child):int;
+            if (best_task <= bound) { // bounding and pruning
+              child.bound = bound;
               children.pushBack(child);
               tree_loc += 1;
             }
           }
         }
       }
-
-      return children;
     }
 
-    override proc decompose(type Node, const parent: Node, ref tree_loc: int, ref num_sol: int,
-      ref max_depth: int, ref best: int, lock: sync bool, ref best_task: int): list(?)
+    override proc decompose(type Node, const parent: Node, ref children, ref tree_loc: int,
+      ref num_sol: int, ref max_depth: int, ref best_task: int, incumbent: borrowed Incumbent): void
     {
-      select this.ub_name {
-        when "dantzig" {
-          return decompose_dantzig(Node, parent, tree_loc, num_sol, max_depth, best, lock, best_task);
-        }
-        when "martello" {
-          return decompose_martello(Node, parent, tree_loc, num_sol, max_depth, best, lock, best_task);
-        }
-        otherwise {
-          halt("DEADCODE");
-        }
-      }
+      if (ubId == DANTZIG) then
+        decompose_dantzig(Node, parent, children, tree_loc, num_sol, max_depth, best_task, incumbent);
+      else if (ubId == MARTELLO) then
+        decompose_martello(Node, parent, children, tree_loc, num_sol, max_depth, best_task, incumbent);
+      else
+        compilerError("Unsupported upper bound");
     }
 
     override proc getInitBound(): int
@@ -248,6 +257,16 @@ module Problem_Knapsack
       return this.initLB;
     }
 
+    override proc getMaxDepth(): int
+    {
+      return this.N: int;
+    }
+
+    override proc isMinimization(): bool
+    {
+      return false;
+    }
+
     // =======================
     // Utility functions
     // =======================
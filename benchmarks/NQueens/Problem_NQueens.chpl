@@ -1,8 +1,7 @@
 module Problem_NQueens
 {
-  use List;
-
   use Problem;
+  use Incumbent;
 
   class Problem_NQueens : Problem
   {
@@ -35,11 +34,9 @@ module Problem_NQueens
       return true;
     }
 
-    override proc decompose(type Node, const parent: Node, ref tree_loc: int, ref num_sol: int,
-      ref max_depth: int, ref best: int, lock: sync bool, ref best_task: int): list(?)
+    override proc decompose(type Node, const parent: Node, ref children, ref tree_loc: int,
+      ref num_sol: int, ref max_depth: int, ref best_task: int, incumbent: borrowed Incumbent): void
     {
-      var children: list(Node);
-
       const depth = parent.depth;
 
       if (depth == this.N) { // All queens are placed
@@ -54,8 +51,6 @@ module Problem_NQueens
           tree_loc += 1;
         }
       }
-
-      return children;
     }
 
     // No bounding in NQueens
@@ -64,6 +59,17 @@ module Problem_NQueens
       return 0;
     }
 
+    // all nodes have the same bound
+    override proc getBound(const node): int
+    {
+      return 0;
+    }
+
+    override proc getMaxDepth(): int
+    {
+      return this.N;
+    }
+
     // =======================
     // Utility functions
     // =======================
@@ -13,8 +13,13 @@ module Header_chpl_c_PFSP
 	extern proc fill_min_heads_tails(const data: c_ptr(bound_data)): void;
 	extern proc eval_solution(const data: c_ptrConst(bound_data), const permutation: c_ptrConst(c_int)): c_int;
 	extern proc lb1_bound(const data: c_ptrConst(bound_data), const permutation: c_ptrConst(c_int), const limit1:c_int, const limit2: c_int): c_int;
+	extern proc lb1_bound_batch(const data: c_ptrConst(bound_data), const permutations: c_ptrConst(c_int), const limit1s: c_ptrConst(c_int), const limit2: c_int,
+		const nb_nodes: c_int, const bounds: c_ptr(c_int)): void;
 	extern proc lb1_children_bounds(const data: c_ptrConst(bound_data), const permutation: c_ptrConst(c_int), const limit1:c_int, const limit2: c_int,
 		const lb_begin: c_ptr(c_int), const lb_end: c_ptr(c_int), const prio_begin: c_ptr(c_int), const prio_end: c_ptr(c_int), const direction: c_int): void;
+	extern proc neh_heuristic(const data: c_ptrConst(bound_data), const permutation: c_ptr(c_int)): c_int;
+	extern proc iterated_greedy(const data: c_ptrConst(bound_data), const permutation: c_ptr(c_int), const iterations: c_int,
+		const d: c_int, const seed: c_uint): c_int;
 
 	require "c_sources/c_bound_johnson.c", "c_headers/c_bound_johnson.h";
 
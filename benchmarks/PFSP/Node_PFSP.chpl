@@ -10,6 +10,8 @@ module Node_PFSP
     var depth: int;
     var limit1: int; // right limit
     var limit2: int; // left limit
+    var bound: int;  // lower bound
+    var idle: int;   // idle time added by the last scheduled job (lb1_d only)
     var prmu: c_array(c_int, JobsMax);
 
     // default-initializer
@@ -31,10 +33,9 @@ module Node_PFSP
       this.depth  = other.depth;
       this.limit1 = other.limit1;
       this.limit2 = other.limit2;
+      this.bound  = other.bound;
+      this.idle   = other.idle;
       this.prmu   = other.prmu;
     }
-
-    proc deinit()
-    {}
   }
 }
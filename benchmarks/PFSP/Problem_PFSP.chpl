@@ -1,10 +1,11 @@
 module Problem_PFSP
 {
-  use List;
   use Path;
   use CTypes;
 
   use Problem;
+  use util only childOrder;
+  use Incumbent;
   use Instances;
   use Header_chpl_c_PFSP;
 
@@ -14,12 +15,63 @@ module Problem_PFSP
   const allowedLowerBounds = ["lb1", "lb1_d", "lb2"];
   const allowedBranchingRules = ["fwd", "bwd", "alt", "maxSum", "minMin", "minBranch"];
 
+  // Identifiers of the lower bounds and branching rules (indices in the arrays above)
+  param LB1 = 0, LB1_D = 1, LB2 = 2;
+  param FWD = 0, BWD = 1, ALT = 2, MAXSUM = 3, MINMIN = 4, MINBRANCH = 5;
+
+  // Number of jobs removed and reinserted by each step of the iterated greedy
+  param IG_DESTRUCTION: c_int = 4;
+  // Number of steps of the iterated greedy between two checks of the end of the
+  // search (see 'improveIncumbent'): a step costs a full local search on large
+  // instances, so that the heuristic task must check often to stop promptly
+  param IG_ROUND: int = 4;
+
   param BEGIN: c_int    =-1;
   param BEGINEND: c_int = 0;
   param END: c_int      = 1;
 
+  /*
+    Check the lower bound and branching rule given by name, and return their
+    identifiers, which parameterize `Problem_PFSP`.
+  */
+  proc pfspVariant(const lb: string, const rules: string): (int, int)
+  {
+    const lbId = allowedLowerBounds.find(lb);
+    if (lbId == -1) then halt("Error - Unsupported lower bound");
+
+    var brId = allowedBranchingRules.find(rules);
+    if (brId == -1) then halt("Error - Unsupported branching rule");
+
+    if ((lbId != LB1_D) && (brId != FWD)) {
+      warning("Branching rules other than `fwd` are only supported by the `lb1_d` bounding function. `fwd` applies.");
+      brId = FWD;
+    }
+
+    return (lbId, brId);
+  }
+
+  /*
+    Upper bound given by the NEH construction, improved by `igIter` steps of the
+    iterated greedy of Ruiz and Stützle (2007).
+  */
+  proc heuristicUB(const lbound1: c_ptr(bound_data), const jobs: c_int, const igIter: int): int
+  {
+    var prmu: [0..#jobs] c_int;
+
+    neh_heuristic(lbound1, c_ptrTo(prmu[0]));
+
+    return iterated_greedy(lbound1, c_ptrTo(prmu[0]), igIter:c_int, IG_DESTRUCTION, 1:c_uint): int;
+  }
+
+  /*
+    The lower bound `lbId` and the branching rule `brId` are compile-time
+    parameters, so that the decomposition is specialized for each of them.
+  */
   class Problem_PFSP : Problem
   {
+    param lbId: int;
+    param brId: int;
+
     var name: string;
     var jobs: c_int;
     var machines: c_int;
@@ -29,13 +81,16 @@ module Problem_PFSP
     var lbound2: c_ptr(johnson_bd_data);
 
     var branching: string;
-    var branchingSide: c_int;
 
     var ub_init: string;
     var initUB: int;
+    var igIter: int;
 
-    proc init(const fileName: string, const lb: string, const rules: string, const ub: string): void
+    proc init(param lbId: int, param brId: int, const fileName: string, const ub: string,
+      const igIter: int = 1000): void
     {
+      this.lbId = lbId;
+      this.brId = brId;
       this.name = fileName;
 
       var inst = new Instance();
@@ -46,35 +101,26 @@ module Problem_PFSP
       this.jobs     = inst.get_nb_jobs();
       this.machines = inst.get_nb_machines();
 
-      if (allowedLowerBounds.find(lb) != -1) then this.lb_name = lb;
-      else halt("Error - Unsupported lower bound");
+      this.lb_name = allowedLowerBounds[lbId];
 
       this.lbound1 = new_bound_data(jobs, machines);
       inst.get_data(lbound1.deref().p_times);
       fill_min_heads_tails(lbound1);
 
-      if (lb == "lb2") {
+      if (lbId == LB2) {
         this.lbound2 = new_johnson_bd_data(lbound1/*, LB2_FULL*/);
         fill_machine_pairs(lbound2/*, LB2_FULL*/);
         fill_lags(lbound1, lbound2);
         fill_johnson_schedules(lbound1, lbound2);
       }
 
-      if (allowedBranchingRules.find(rules) != -1) then this.branching = rules;
-      else halt("Error - Unsupported branching rule");
-
-      if ((lb != "lb1_d") && (rules != "fwd")) {
-        warning("Branching rules other than `fwd` are only supported by the `lb1_d` bounding function. `fwd` applies.");
-        this.branching = "fwd";
-      }
-
-      if (rules == "fwd") then this.branchingSide = BEGIN;
-      else if (rules == "bwd") then this.branchingSide = END;
-      else this.branchingSide = BEGINEND;
+      this.branching = allowedBranchingRules[brId];
 
       this.ub_init = ub;
+      this.igIter = igIter;
       if (ub == "opt") then this.initUB = inst.get_best_ub();
       else if (ub == "inf") then this.initUB = max(int);
+      else if (ub == "heur") then this.initUB = heuristicUB(lbound1, jobs, igIter);
       else {
         try! this.initUB = ub:int;
 
@@ -93,74 +139,79 @@ module Problem_PFSP
     proc deinit()
     {
       free_bound_data(this.lbound1);
-      if (this.lb_name == "lb2") then free_johnson_bd_data(this.lbound2);
+      if (lbId == LB2) then free_johnson_bd_data(this.lbound2);
     }
 
     // TODO: Implement a copy initializer, to avoid re-computing all the data
     override proc copy()
     {
-      return new Problem_PFSP(this.name, this.lb_name, this.branching, this.ub_init);
+      // the heuristic upper bound is passed as is, rather than re-computed
+      const ub = if (this.ub_init == "heur") then this.initUB:string else this.ub_init;
+      return new Problem_PFSP(lbId, brId, this.name, ub, this.igIter);
     }
 
-    inline proc branchingRule(const lb_begin, const lb_end, const depth, const best)
+    proc branchingSide param: c_int
     {
-      var branch = this.branching;
+      if (brId == FWD) then return BEGIN;
+      else if (brId == BWD) then return END;
+      else return BEGINEND;
+    }
 
-      while true {
-        select branch {
-          when "alt" {
-            if (depth % 2 == 0) then return BEGIN;
-            else return END;
-          }
-          when "maxSum" {
-            var sum1, sum2 = 0;
-            for i in 0..#this.jobs {
-              sum1 += lb_begin[i];
-              sum2 += lb_end[i];
-            }
-            if (sum1 >= sum2) then return BEGIN;
-            else return END;
-          }
-          when "minMin" {
-            var min0 = max(int);
-            for k in 0..#this.jobs {
-              if lb_begin[k] then min0 = min(lb_begin[k], min0);
-              if lb_end[k] then min0 = min(lb_end[k], min0);
-            }
-            var c1, c2 = 0;
-            for k in 0..#this.jobs {
-              if (lb_begin[k] == min0) then c1 += 1;
-              if (lb_end[k] == min0) then c2 += 1;
-            }
-            if (c1 < c2) then return BEGIN;
-            else if (c1 == c2) then branch = "minBranch";
-            else return END;
-          }
-          when "minBranch" {
-            var c, s: int;
-            for i in 0..#this.jobs {
-              if (lb_begin[i] >= best) then c += 1;
-              if (lb_end[i] >= best) then c -= 1;
-              s += (lb_begin[i] - lb_end[i]);
-            }
-            if (c > 0) then return BEGIN;
-            else if (c < 0) then return END;
-            else {
-              if (s < 0) then return END;
-              else return BEGIN;
-            }
-          }
-          otherwise halt("Error - Unsupported branching rule");
+    inline proc branchingRule(const lb_begin, const lb_end, const depth, const best)
+    {
+      if (brId == ALT) {
+        if (depth % 2 == 0) then return BEGIN;
+        else return END;
+      }
+      else if (brId == MAXSUM) {
+        var sum1, sum2 = 0;
+        for i in 0..#this.jobs {
+          sum1 += lb_begin[i];
+          sum2 += lb_end[i];
         }
+        if (sum1 >= sum2) then return BEGIN;
+        else return END;
       }
-      halt("DEADCODE");
+      else if (brId == MINMIN) {
+        var min0 = max(int);
+        for k in 0..#this.jobs {
+          if lb_begin[k] then min0 = min(lb_begin[k], min0);
+          if lb_end[k] then min0 = min(lb_end[k], min0);
+        }
+        var c1, c2 = 0;
+        for k in 0..#this.jobs {
+          if (lb_begin[k] == min0) then c1 += 1;
+          if (lb_end[k] == min0) then c2 += 1;
+        }
+        if (c1 < c2) then return BEGIN;
+        else if (c1 == c2) then return minBranchRule(lb_begin, lb_end, best);
+        else return END;
+      }
+      else if (brId == MINBRANCH) {
+        return minBranchRule(lb_begin, lb_end, best);
+      }
+      else compilerError("Unsupported branching rule");
     }
 
-    proc decompose_lb1(type Node, const parent: Node, ref tree_loc: int, ref num_sol: int,
-      ref max_depth: int, ref best: int, lock: sync bool, ref best_task: int): list(?)
+    inline proc minBranchRule(const lb_begin, const lb_end, const best)
     {
-      var children: list(Node);
+      var c, s: int;
+      for i in 0..#this.jobs {
+        if (lb_begin[i] >= best) then c += 1;
+        if (lb_end[i] >= best) then c -= 1;
+        s += (lb_begin[i] - lb_end[i]);
+      }
+      if (c > 0) then return BEGIN;
+      else if (c < 0) then return END;
+      else {
+        if (s < 0) then return END;
+        else return BEGIN;
+      }
+    }
 
+    proc decompose_lb1(type Node, const parent: Node, ref children, ref tree_loc: int,
+      ref num_sol: int, ref max_depth: int, ref best_task: int, incumbent: borrowed Incumbent): void
+    {
       /* If the parent node is a leaf, we evaluate its permutation and compare it
       against the best evaluation found so far. Otherwise, we generate its children
       nodes and compare their lower bound against the best evaluation found so far. */
@@ -169,16 +220,13 @@ module Problem_PFSP
 
         if (eval < best_task) {
           best_task = eval;
-          lock.readFE();
-          if eval <= best {
-            best = eval;
+          if incumbent.update(eval) {
             num_sol = 1;
           }
           else {
-            best_task = best;
+            best_task = incumbent.read();
             num_sol = 0;
           }
-          lock.writeEF(true);
         }
         else if (eval == best_task) {
           num_sol += 1;
@@ -194,20 +242,17 @@ module Problem_PFSP
           const lb = lb1_bound(lbound1, child.prmu, child.limit1:c_int, jobs);
 
           if (lb <= best_task) {
+            child.bound = lb;
             children.pushBack(child);
             tree_loc += 1;
           }
         }
       }
-
-      return children;
     }
 
-    proc decompose_lb1_d(type Node, const parent: Node, ref tree_loc: int, ref num_sol: int,
-      ref max_depth: int, ref best: int, lock: sync bool, ref best_task: int): list(?)
+    proc decompose_lb1_d(type Node, const parent: Node, ref children, ref tree_loc: int,
+      ref num_sol: int, ref max_depth: int, ref best_task: int, incumbent: borrowed Incumbent): void
     {
-      var children: list(Node);
-
       /* If the parent node is a leaf, we evaluate its permutation and compare it
       against the best evaluation found so far. Otherwise, we generate its children
       nodes and compare their lower bound against the best evaluation found so far. */
@@ -216,16 +261,13 @@ module Problem_PFSP
 
         if (eval < best_task) {
           best_task = eval;
-          lock.readFE();
-          if eval <= best {
-            best = eval;
+          if incumbent.update(eval) {
             num_sol = 1;
           }
           else {
-            best_task = best;
+            best_task = incumbent.read();
             num_sol = 0;
           }
-          lock.writeEF(true);
         }
         else if (eval == best_task) {
           num_sol += 1;
@@ -234,12 +276,14 @@ module Problem_PFSP
       else {
         var lb_begin = allocate(c_int, this.jobs);
         var lb_end = allocate(c_int, this.jobs);
-        /* var prio_begin = allocate(c_int, this.jobs);
-        var prio_end = allocate(c_int, this.jobs); */
+        // the idle times are only needed to order the children (see 'childKey')
+        const withPrio = (childOrder == "problem");
+        var prio_begin = if withPrio then allocate(c_int, this.jobs) else nil: c_ptr(c_int);
+        var prio_end = if withPrio then allocate(c_int, this.jobs) else nil: c_ptr(c_int);
         var beginEnd = this.branchingSide;
 
         lb1_children_bounds(this.lbound1, parent.prmu, parent.limit1:c_int, parent.limit2:c_int,
-          lb_begin, lb_end, nil, nil, beginEnd);
+          lb_begin, lb_end, prio_begin, prio_end, beginEnd);
 
         if (this.branchingSide == BEGINEND) {
           beginEnd = branchingRule(lb_begin, lb_end, parent.depth, best_task);
@@ -252,6 +296,9 @@ module Problem_PFSP
           if (lb <= best_task) {
             var child = new Node(parent);
             child.depth += 1;
+            child.bound = lb;
+            if withPrio then
+              child.idle = (beginEnd == BEGIN) * prio_begin[job] + (beginEnd == END) * prio_end[job];
 
             if (beginEnd == BEGIN) {
               child.limit1 += 1;
@@ -267,17 +314,15 @@ module Problem_PFSP
         }
 
         deallocate(lb_begin); deallocate(lb_end);
-        /* deallocate(prio_begin); deallocate(prio_end); */
+        if withPrio {
+          deallocate(prio_begin); deallocate(prio_end);
+        }
       }
-
-      return children;
     }
 
-    proc decompose_lb2(type Node, const parent: Node, ref tree_loc: int, ref num_sol: int,
-      ref max_depth: int, ref best: int, lock: sync bool, ref best_task: int): list(?)
+    proc decompose_lb2(type Node, const parent: Node, ref children, ref tree_loc: int,
+      ref num_sol: int, ref max_depth: int, ref best_task: int, incumbent: borrowed Incumbent): void
     {
-      var children: list(Node);
-
       /* If the parent node is a leaf, we evaluate its permutation and compare it
       against the best evaluation found so far. Otherwise, we generate its children
       nodes and compare their lower bound against the best evaluation found so far. */
@@ -286,16 +331,13 @@ module Problem_PFSP
 
         if (eval < best_task) {
           best_task = eval;
-          lock.readFE();
-          if eval <= best {
-            best = eval;
+          if incumbent.update(eval) {
             num_sol = 1;
           }
           else {
-            best_task = best;
+            best_task = incumbent.read();
             num_sol = 0;
           }
-          lock.writeEF(true);
         }
         else if (eval == best_task) {
           num_sol += 1;
@@ -311,32 +353,97 @@ module Problem_PFSP
           const lb = lb2_bound(lbound1, lbound2, child.prmu, child.limit1:c_int, jobs, best_task:c_int);
 
           if (lb <= best_task) {
+            child.bound = lb;
             children.pushBack(child);
             tree_loc += 1;
           }
         }
       }
+    }
 
-      return children;
+    override proc decompose(type Node, const parent: Node, ref children, ref tree_loc: int,
+      ref num_sol: int, ref max_depth: int, ref best_task: int, incumbent: borrowed Incumbent): void
+    {
+      if (lbId == LB1) then
+        decompose_lb1(Node, parent, children, tree_loc, num_sol, max_depth, best_task, incumbent);
+      else if (lbId == LB1_D) then
+        decompose_lb1_d(Node, parent, children, tree_loc, num_sol, max_depth, best_task, incumbent);
+      else if (lbId == LB2) then
+        decompose_lb2(Node, parent, children, tree_loc, num_sol, max_depth, best_task, incumbent);
+      else
+        compilerError("Unsupported lower bound");
     }
 
-    override proc decompose(type Node, const parent: Node, ref tree_loc: int, ref num_sol: int,
-      ref max_depth: int, ref best: int, lock: sync bool, ref best_task: int): list(?)
+    /*
+      Batched version of `decompose_lb1`: the children of all the parents are
+      bounded by a single call to the C kernel, and only those surviving the
+      pruning are built.
+    */
+    proc decomposeBatch_lb1(type Node, const parents: [] Node, const nParents: int, ref children,
+      ref tree_loc: int, ref num_sol: int, ref max_depth: int, ref best_task: int,
+      incumbent: borrowed Incumbent): void
     {
-      select this.lb_name {
-        when "lb1" {
-          return decompose_lb1(Node, parent, tree_loc, num_sol, max_depth, best, lock, best_task);
-        }
-        when "lb1_d" {
-          return decompose_lb1_d(Node, parent, tree_loc, num_sol, max_depth, best, lock, best_task);
-        }
-        when "lb2" {
-          return decompose_lb2(Node, parent, tree_loc, num_sol, max_depth, best, lock, best_task);
+      var nChildren = 0;
+      for p in 0..#nParents {
+        const ref parent = parents[p];
+        // leaves are evaluated first, as they may improve the upper bound
+        if (parent.depth + 1 == jobs) then
+          decompose_lb1(Node, parent, children, tree_loc, num_sol, max_depth, best_task, incumbent);
+        else
+          nChildren += parent.limit2 - parent.limit1 - 1;
+      }
+
+      if (nChildren == 0) then return;
+
+      var prmus = allocate(c_int, nChildren * jobs);
+      var limits1 = allocate(c_int, nChildren);
+      var bounds = allocate(c_int, nChildren);
+      var origins = allocate(2*int, nChildren); // (parent, swapped position)
+
+      var k = 0;
+      for p in 0..#nParents {
+        const ref parent = parents[p];
+        if (parent.depth + 1 == jobs) then continue;
+
+        for i in parent.limit1+1..parent.limit2-1 {
+          const prmu = prmus + k * jobs;
+          for j in 0..#jobs do prmu[j] = parent.prmu[j];
+          swap(prmu[parent.depth], prmu[i]);
+          limits1[k] = (parent.limit1 + 1):c_int;
+          origins[k] = (p, i);
+          k += 1;
         }
-        otherwise {
-          halt("DEADCODE");
+      }
+
+      lb1_bound_batch(lbound1, prmus, limits1, jobs, nChildren:c_int, bounds);
+
+      for k in 0..#nChildren {
+        if (bounds[k] <= best_task) {
+          const (p, i) = origins[k];
+          var child = new Node(parents[p]);
+          swap(child.prmu[child.depth], child.prmu[i]);
+          child.depth  += 1;
+          child.limit1 += 1;
+          child.bound = bounds[k];
+          children.pushBack(child);
+          tree_loc += 1;
         }
       }
+
+      deallocate(prmus); deallocate(limits1);
+      deallocate(bounds); deallocate(origins);
+    }
+
+    override proc decomposeBatch(type Node, const parents: [] Node, const nParents: int, ref children,
+      ref tree_loc: int, ref num_sol: int, ref max_depth: int, ref best_task: int,
+      incumbent: borrowed Incumbent): void
+    {
+      if (lbId == LB1) then
+        decomposeBatch_lb1(Node, parents, nParents, children, tree_loc, num_sol, max_depth,
+          best_task, incumbent);
+      else
+        for i in 0..#nParents do
+          decompose(Node, parents[i], children, tree_loc, num_sol, max_depth, best_task, incumbent);
     }
 
     override proc getInitBound(): int
@@ -344,6 +451,40 @@ module Problem_PFSP
       return this.initUB;
     }
 
+    /*
+      Children are explored by increasing lower bound, then by increasing idle time
+      added to the partial schedule (computed by `lb1_d` only).
+    */
+    override proc childKey(const node): int
+    {
+      return (node.bound << 32) + node.idle;
+    }
+
+    override proc getMaxDepth(): int
+    {
+      return this.jobs: int;
+    }
+
+    /*
+      Keep improving a schedule built by NEH with the iterated greedy, publishing
+      each improvement, until `done` is set.
+    */
+    override proc improveIncumbent(incumbent: borrowed Incumbent, const ref done: atomic bool): void
+    {
+      var prmu: [0..#jobs] c_int;
+      var round: int = 0;
+
+      neh_heuristic(lbound1, c_ptrTo(prmu[0]));
+
+      while !done.read() {
+        const cmax = iterated_greedy(lbound1, c_ptrTo(prmu[0]), IG_ROUND:c_int, IG_DESTRUCTION,
+          (1 + round):c_uint);
+        round += 1;
+
+        if incumbent.isBetter(cmax, incumbent.read()) then incumbent.update(cmax);
+      }
+    }
+
     // =======================
     // Utility functions
     // =======================
@@ -398,7 +539,8 @@ module Problem_PFSP
       writeln("   --inst   str       instance's name");
       writeln("   --lb     str       lower bound function (lb1, lb1_d, lb2)");
       writeln("   --br     str       branching rule (fwd, bwd, alt, maxSum, minMin, minBranch)");
-      writeln("   --ub     str/int   upper bound initialization ('opt', 'inf', or any integer)\n");
+      writeln("   --ub     str/int   upper bound initialization ('opt', 'inf', 'heur', or any integer)");
+      writeln("   --igIter int       number of iterated greedy steps of the 'heur' upper bound\n");
     }
 
   } // end class
@@ -50,8 +50,19 @@ int eval_solution(const bound_data* const data, const int* const permutation);
 
 int lb1_bound(const bound_data* const data, const int * const permut, const int limit1, const int limit2);
 
+// lb1 of 'nb_nodes' partial schedules, stored contiguously (nb_jobs each) in 'permutations'
+void lb1_bound_batch(const bound_data* const data, const int * const permutations, const int * const limit1s, const int limit2, const int nb_nodes, int * const bounds);
+
 void lb1_children_bounds(const bound_data* const data, const int* const permutation, const int limit1, const int limit2, int* const lb_begin, int* const lb_end, int* const prio_begin, int* const prio_end, const int direction);
 
+//------------------upper bound heuristics------------------
+// NEH construction: writes the schedule in 'permutation' and returns its makespan
+int neh_heuristic(const bound_data* const data, int* const permutation);
+
+// iterated greedy of Ruiz and Stützle (2007), improving the complete schedule 'permutation'
+// in place over 'iterations' destruction-construction steps of 'd' jobs; returns its makespan
+int iterated_greedy(const bound_data* const data, int* const permutation, const int iterations, const int d, const unsigned int seed);
+
 // #ifdef __cplusplus
 // }
 // #endif
@@ -2,6 +2,7 @@
 
 #include <limits.h>
 #include <string.h>
+#include <math.h>
 
 bound_data* new_bound_data(int _jobs, int _machines)
 {
@@ -160,6 +161,29 @@ lb1_bound(const bound_data* const data, const int * const permut, const int limi
   return machine_bound_from_parts(front, back, remain, nb_machines);
 }
 
+void
+lb1_bound_batch(const bound_data* const data, const int * const permutations, const int * const limit1s,
+  const int limit2, const int nb_nodes, int * const bounds)
+{
+  int nb_jobs = data->nb_jobs;
+  int nb_machines = data->nb_machines;
+
+  int front[nb_machines];
+  int back[nb_machines];
+  int remain[nb_machines];
+
+  for (int k = 0; k < nb_nodes; k++) {
+    const int * const permut = permutations + k * nb_jobs;
+
+    schedule_front(data, permut, limit1s[k], front);
+    schedule_back(data, permut, limit2, back);
+
+    sum_unscheduled(data, permut, limit1s[k], limit2, remain);
+
+    bounds[k] = machine_bound_from_parts(front, back, remain, nb_machines);
+  }
+}
+
 void lb1_children_bounds(const bound_data *const data, const int *const permutation, const int limit1, const int limit2, int *const lb_begin, int *const lb_end, int *const prio_begin, int *const prio_end, const int direction)
 {
   int N = data->nb_jobs;
@@ -327,3 +351,214 @@ fill_min_heads_tails(bound_data* data)
 // #ifdef __cplusplus
 // }
 // #endif
+
+//------------------upper bound heuristics------------------
+
+// xorshift32 generator, reentrant
+static unsigned int
+next_random(unsigned int *state)
+{
+  unsigned int x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  return *state = x;
+}
+
+// best position to insert 'job' in the partial schedule 'seq' of 'k' jobs, with the
+// acceleration of Taillard (1990); 'e', 'q' and 'f' hold (k+1)*nb_machines integers
+static int
+best_insertion(const bound_data* const data, const int* const seq, const int k, const int job,
+  int* const e, int* const q, int* const f, int* const cmax)
+{
+  const int N = data->nb_jobs;
+  const int M = data->nb_machines;
+  const int *const p = data->p_times;
+
+  // earliest completion times of the jobs of 'seq'
+  for (int i = 0; i < k; i++) {
+    for (int j = 0; j < M; j++) {
+      int t = (i > 0) ? e[(i-1)*M + j] : 0;
+      if (j > 0) t = MAX(t, e[i*M + j-1]);
+      e[i*M + j] = t + p[j*N + seq[i]];
+    }
+  }
+  // tails of the jobs of 'seq'
+  for (int j = 0; j < M; j++) q[k*M + j] = 0;
+  for (int i = k-1; i >= 0; i--) {
+    for (int j = M-1; j >= 0; j--) {
+      int t = q[(i+1)*M + j];
+      if (j < M-1) t = MAX(t, q[i*M + j+1]);
+      q[i*M + j] = t + p[j*N + seq[i]];
+    }
+  }
+
+  int best_pos = 0;
+  int best_cmax = INT_MAX;
+
+  for (int i = 0; i <= k; i++) {
+    int c = 0;
+    for (int j = 0; j < M; j++) {
+      int t = (i > 0) ? e[(i-1)*M + j] : 0;
+      if (j > 0) t = MAX(t, f[i*M + j-1]);
+      f[i*M + j] = t + p[j*N + job];
+      c = MAX(c, f[i*M + j] + q[i*M + j]);
+    }
+    if (c < best_cmax) {
+      best_cmax = c;
+      best_pos = i;
+    }
+  }
+
+  *cmax = best_cmax;
+  return best_pos;
+}
+
+static void
+insert_at(int* const seq, const int k, const int pos, const int job)
+{
+  memmove(seq + pos + 1, seq + pos, (k - pos) * sizeof(int));
+  seq[pos] = job;
+}
+
+static void
+remove_at(int* const seq, const int k, const int pos)
+{
+  memmove(seq + pos, seq + pos + 1, (k - pos - 1) * sizeof(int));
+}
+
+// insertion local search: each job is reinserted at its best position, until no move improves
+static int
+local_search(const bound_data* const data, int* const seq, int cmax, int* const e, int* const q,
+  int* const f, unsigned int* const state)
+{
+  const int N = data->nb_jobs;
+  int improved = 1;
+
+  while (improved) {
+    improved = 0;
+    const int start = next_random(state) % N;
+
+    for (int r = 0; r < N; r++) {
+      const int i = (start + r) % N;
+      const int job = seq[i];
+      int c;
+
+      remove_at(seq, N, i);
+      const int pos = best_insertion(data, seq, N-1, job, e, q, f, &c);
+      insert_at(seq, N-1, pos, job);
+
+      if (c < cmax) {
+        cmax = c;
+        improved = 1;
+      }
+    }
+  }
+
+  return cmax;
+}
+
+int
+neh_heuristic(const bound_data* const data, int* const permutation)
+{
+  const int N = data->nb_jobs;
+  const int M = data->nb_machines;
+  const int *const p = data->p_times;
+
+  int *order = malloc(N * sizeof(int));
+  int *total = malloc(N * sizeof(int));
+  int *ws = malloc(3 * (N+1) * M * sizeof(int));
+
+  // jobs by decreasing total processing time (stable)
+  for (int i = 0; i < N; i++) {
+    total[i] = 0;
+    for (int j = 0; j < M; j++) total[i] += p[j*N + i];
+
+    int k = i;
+    while ((k > 0) && (total[order[k-1]] < total[i])) {
+      order[k] = order[k-1];
+      k--;
+    }
+    order[k] = i;
+  }
+
+  int cmax = 0;
+  for (int k = 0; k < N; k++) {
+    const int pos = best_insertion(data, permutation, k, order[k], ws, ws + (N+1)*M, ws + 2*(N+1)*M, &cmax);
+    insert_at(permutation, k, pos, order[k]);
+  }
+
+  free(ws); free(total); free(order);
+
+  return cmax;
+}
+
+int
+iterated_greedy(const bound_data* const data, int* const permutation, const int iterations,
+  const int d, const unsigned int seed)
+{
+  const int N = data->nb_jobs;
+  const int M = data->nb_machines;
+  const int *const p = data->p_times;
+  const int nd = MIN(d, N-1);
+  unsigned int state = (seed == 0) ? 2463534242u : seed;
+
+  int *cur = malloc(N * sizeof(int));
+  int *cand = malloc(N * sizeof(int));
+  int *removed = malloc(N * sizeof(int));
+  int *ws = malloc(3 * (N+1) * M * sizeof(int));
+  int *e = ws, *q = ws + (N+1)*M, *f = ws + 2*(N+1)*M;
+
+  // temperature of the acceptance criterion, as in the original paper (T = 0.4)
+  long sum = 0;
+  for (int i = 0; i < N*M; i++) sum += p[i];
+  const double temperature = 0.4 * sum / (10.0 * N * M);
+
+  memcpy(cur, permutation, N * sizeof(int));
+  int cur_cmax = local_search(data, cur, eval_solution(data, cur), e, q, f, &state);
+  int best_cmax = eval_solution(data, permutation);
+
+  if (cur_cmax < best_cmax) {
+    best_cmax = cur_cmax;
+    memcpy(permutation, cur, N * sizeof(int));
+  }
+
+  for (int it = 0; (it < iterations) && (N > 1); it++) {
+    memcpy(cand, cur, N * sizeof(int));
+
+    // destruction
+    int k = N;
+    for (int r = 0; r < nd; r++) {
+      const int i = next_random(&state) % k;
+      removed[r] = cand[i];
+      remove_at(cand, k, i);
+      k--;
+    }
+
+    // construction
+    int c = 0;
+    for (int r = 0; r < nd; r++) {
+      const int pos = best_insertion(data, cand, k, removed[r], e, q, f, &c);
+      insert_at(cand, k, pos, removed[r]);
+      k++;
+    }
+
+    c = local_search(data, cand, c, e, q, f, &state);
+
+    // acceptance
+    const double u = (next_random(&state) % 1000000) / 1000000.0;
+    if ((c < cur_cmax) || (u < exp(-(c - cur_cmax) / temperature))) {
+      memcpy(cur, cand, N * sizeof(int));
+      cur_cmax = c;
+
+      if (c < best_cmax) {
+        best_cmax = c;
+        memcpy(permutation, cand, N * sizeof(int));
+      }
+    }
+  }
+
+  free(ws); free(removed); free(cand); free(cur);
+
+  return best_cmax;
+}
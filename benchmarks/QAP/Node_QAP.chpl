@@ -67,5 +67,40 @@ module Node_QAP
         }
       }
     }
+
+    // binary encoding of the fields, used by the distributed bag to spill nodes
+    // to disk, as the arrays live on the heap
+    proc writeFields(writer) throws
+    {
+      for m in this.mapping do writer.writeBinary(m);
+      writer.writeBinary(this.lower_bound);
+      writer.writeBinary(this.depth);
+      for a in this.available do writer.writeBinary(a:uint(8));
+      writer.writeBinary(this.domCost.size:int(32));
+      writer.writeBinary(this.costs);
+      writer.writeBinary(this.domLeader.size:int(32));
+      writer.writeBinary(this.leader);
+      writer.writeBinary(this.size);
+    }
+
+    proc ref readFields(reader) throws
+    {
+      for i in 0..<sizeMax do reader.readBinary(this.mapping[i]);
+      reader.readBinary(this.lower_bound);
+      reader.readBinary(this.depth);
+      for i in 0..<sizeMax {
+        var a: uint(8);
+        reader.readBinary(a);
+        this.available[i] = (a != 0);
+      }
+      var n: int(32);
+      reader.readBinary(n);
+      this.domCost = {0..<n};
+      reader.readBinary(this.costs);
+      reader.readBinary(n);
+      this.domLeader = {0..<n};
+      reader.readBinary(this.leader);
+      reader.readBinary(this.size);
+    }
   }
 }
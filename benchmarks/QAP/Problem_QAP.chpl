@@ -1,16 +1,37 @@
 module Problem_QAP
 {
-  use List;
   use CTypes;
 
   use Util;
   use Problem;
+  use Incumbent;
   use Instances;
 
   const allowedLowerBounds = ["glb", "hhb"];
 
+  // Identifiers of the lower bounds (indices in the array above)
+  param GLB = 0, HHB = 1;
+
+  /*
+    Check the lower bound given by name, and return its identifier, which
+    parameterizes `Problem_QAP`.
+  */
+  proc lowerBoundId(const lb: string): int
+  {
+    const lbId = allowedLowerBounds.find(lb);
+    if (lbId == -1) then halt("Error - Unsupported lower bound");
+
+    return lbId;
+  }
+
+  /*
+    The lower bound `lbId` is a compile-time parameter, so that the decomposition
+    is specialized for it.
+  */
   class Problem_QAP : Problem
   {
+    param lbId: int;
+
     var filename: string;
     var benchmark: string;
     var n: int(32);
@@ -28,8 +49,9 @@ module Problem_QAP
     var ub_init: string;
     var initUB: int;
 
-    proc init(filename, itmax, lb, ub): void
+    proc init(param lbId: int, filename, itmax, ub): void
     {
+      this.lbId = lbId;
       this.filename = filename;
       var getFilenames = filename.split(",");
 
@@ -60,8 +82,7 @@ module Problem_QAP
 
       this.it_max = itmax;
 
-      if (allowedLowerBounds.find(lb) != -1) then this.lb_name = lb;
-      else halt("Error - Unsupported lower bound");
+      this.lb_name = allowedLowerBounds[lbId];
 
       this.ub_init = ub;
       if (ub == "heuristic") then this.initUB = GreedyAllocation(this.D, this.F, this.priority_fac, this.n, this.N);
@@ -80,10 +101,11 @@ module Problem_QAP
       }
     }
 
-    proc init(const filename: string, const benchmark, const N, const D, const n,
-      const F, const priority_fac, const priority_loc, const it_max, const lb_name,
+    proc init(param lbId: int, const filename: string, const benchmark, const N, const D,
+      const n, const F, const priority_fac, const priority_loc, const it_max,
       const ub_init, const initUB): void
     {
+      this.lbId = lbId;
       this.filename = filename;
       this.benchmark = benchmark;
       this.n = n;
@@ -93,14 +115,14 @@ module Problem_QAP
       this.priority_fac = priority_fac;
       this.priority_loc = priority_loc;
       this.it_max = it_max;
-      this.lb_name = lb_name;
+      this.lb_name = allowedLowerBounds[lbId];
       this.ub_init = ub_init;
       this.initUB = initUB;
     }
 
     override proc copy()
     {
-      return new Problem_QAP(this.filename, this.it_max, this.lb_name, this.ub_init);
+      return new Problem_QAP(lbId, this.filename, this.it_max, this.ub_init);
     }
 
     proc RowwiseNumZeros(const ref D, const N)
@@ -525,11 +547,9 @@ module Problem_QAP
       return lb;
     }
 
-    proc decompose_HHB(type Node, const parent: Node, ref tree_loc: int, ref num_sol: int,
-      ref max_depth: int, ref best: int, lock: sync bool, ref best_task: int): list(?)
+    proc decompose_HHB(type Node, const parent: Node, ref children, ref tree_loc: int,
+      ref num_sol: int, ref max_depth: int, ref best_task: int, incumbent: borrowed Incumbent): void
     {
-      var children: list(Node);
-
       var depth = parent.depth;
 
       if (parent.depth == this.n) {
@@ -537,16 +557,13 @@ module Problem_QAP
 
         if (eval < best_task) {
           best_task = eval;
-          lock.readFE();
-          if eval <= best {
-            best = eval;
+          if incumbent.update(eval) {
             num_sol = 1;
           }
           else {
-            best_task = best;
+            best_task = incumbent.read();
             num_sol = 0;
           }
-          lock.writeEF(true);
         }
         else if (eval == best_task) {
           num_sol += 1;
@@ -556,6 +573,9 @@ module Problem_QAP
         }
       }
       else {
+        // bounding is expensive, so we pick up improvements found by other tasks first
+        incumbent.refresh(best_task);
+
         local {
           var i = this.priority_fac[depth];
 
@@ -595,8 +615,6 @@ module Problem_QAP
           }
         }
       }
-
-      return children;
     }
 
     /*******************************************************
@@ -848,11 +866,9 @@ module Problem_QAP
       return fixed_cost + remaining_lb;
     }
 
-    proc decompose_GLB(type Node, const parent: Node, ref tree_loc: int, ref num_sol: int,
-      ref max_depth: int, ref best: int, lock: sync bool, ref best_task: int): list(?)
+    proc decompose_GLB(type Node, const parent: Node, ref children, ref tree_loc: int,
+      ref num_sol: int, ref max_depth: int, ref best_task: int, incumbent: borrowed Incumbent): void
     {
-      var children: list(Node);
-
       var depth = parent.depth;
 
       if (parent.depth == this.n) {
@@ -860,16 +876,13 @@ module Problem_QAP
 
         if (eval < best_task) {
           best_task = eval;
-          lock.readFE();
-          if eval <= best {
-            best = eval;
+          if incumbent.update(eval) {
             num_sol = 1;
           }
           else {
-            best_task = best;
+            best_task = incumbent.read();
             num_sol = 0;
           }
-          lock.writeEF(true);
         }
         else if (eval == best_task) {
           num_sol += 1;
@@ -879,6 +892,9 @@ module Problem_QAP
         }
       }
       else {
+        // bounding is expensive, so we pick up improvements found by other tasks first
+        incumbent.refresh(best_task);
+
         local {
           var i = this.priority_fac[depth];
 
@@ -895,6 +911,7 @@ module Problem_QAP
             if (child.depth < this.n) {
               var lb = bound_GLB(child);
               if (lb <= best_task) {
+                child.lower_bound = lb;
                 children.pushBack(child);
                 tree_loc += 1;
               }
@@ -906,24 +923,17 @@ module Problem_QAP
           }
         }
       }
-
-      return children;
     }
 
-    override proc decompose(type Node, const parent: Node, ref tree_loc: int, ref num_sol: int,
-      ref max_depth: int, ref best: int, lock: sync bool, ref best_task: int): list(?)
+    override proc decompose(type Node, const parent: Node, ref children, ref tree_loc: int,
+      ref num_sol: int, ref max_depth: int, ref best_task: int, incumbent: borrowed Incumbent): void
     {
-      select this.lb_name {
-        when "hhb" {
-          return decompose_HHB(Node, parent, tree_loc, num_sol, max_depth, best, lock, best_task);
-        }
-        when "glb" {
-          return decompose_GLB(Node, parent, tree_loc, num_sol, max_depth, best, lock, best_task);
-        }
-        otherwise {
-          halt("DEADCODE");
-        }
-      }
+      if (lbId == HHB) then
+        decompose_HHB(Node, parent, children, tree_loc, num_sol, max_depth, best_task, incumbent);
+      else if (lbId == GLB) then
+        decompose_GLB(Node, parent, children, tree_loc, num_sol, max_depth, best_task, incumbent);
+      else
+        compilerError("Unsupported lower bound");
     }
 
     override proc print_settings(): void
@@ -940,7 +950,7 @@ module Problem_QAP
         writeln("Number of logical qubits: ", this.n);
         writeln("Number of physical qubits: ", this.N);
       }
-      if (this.lb_name == "hhb") then
+      if (lbId == HHB) then
         writeln("Max bounding iterations: ", this.it_max);
       const heuristic = if (this.ub_init == "heuristic") then " (heuristic)" else "";
       writeln("Initial upper bound: ", this.initUB, heuristic);
@@ -981,6 +991,16 @@ module Problem_QAP
       return this.initUB;
     }
 
+    override proc getBound(const node): int
+    {
+      return node.lower_bound;
+    }
+
+    override proc getMaxDepth(): int
+    {
+      return this.n: int;
+    }
+
     override proc output_filepath(): string
     {
       return "./chpl_qap.txt";
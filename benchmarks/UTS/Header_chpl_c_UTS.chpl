@@ -11,7 +11,9 @@ module Header_chpl_c_UTS
 	extern proc uts_numChildren(const ref parent: Node_UTS, treeType: c_int, nonLeafBF: c_int,
 		nonLeafProb: c_double, b_0: c_double, shape_fn: c_int, gen_mx: c_int, shiftDepth: c_double): c_int;
 
-	extern proc c_decompose(const ref parent: Node_UTS, children: c_ptr(Node_UTS), treeType: c_int,
-		numChildren: c_int, gen_mx: c_int, shiftDepth: c_double, computeGranularity: c_int,
-		ref treeSize: int, ref maxDepth: int): void;
+	extern proc uts_childType(const ref parent: Node_UTS, treeType: c_int, shiftDepth: c_double,
+		gen_mx: c_int): c_int;
+
+	extern proc c_generateChild(const ref parent: Node_UTS, ref child: Node_UTS, childType: c_int,
+		i: c_int, computeGranularity: c_int): void;
 }
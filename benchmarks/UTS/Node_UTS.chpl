@@ -7,6 +7,7 @@ module Node_UTS
 
   extern record Node_UTS
   {
+    var height: c_int;
     var numChildren: c_int;
 
     // default-initializer
@@ -3,6 +3,7 @@ module Problem_UTS
   use CTypes;
 
   use Problem;
+  use Incumbent;
   use Header_chpl_c_UTS;
 
   param BIN: c_int      = 0;
@@ -81,23 +82,27 @@ module Problem_UTS
         this.nonLeafProb, this.gen_mx, this.shape_fn, this.shiftDepth, this.computeGranularity);
     }
 
-    override proc decompose(type Node, const parent: Node, ref tree_loc: int, ref num_sol: int,
-      ref max_depth: int, ref best: int, lock: sync bool, ref best_task: int): [] Node
+    override proc decompose(type Node, const parent: Node, ref children, ref tree_loc: int,
+      ref num_sol: int, ref max_depth: int, ref best_task: int, incumbent: borrowed Incumbent): void
     {
       var numChildren = uts_numChildren(parent, this.treeType, this.nonLeafBF, this.nonLeafProb,
         this.b_0, this.shape_fn, this.gen_mx, this.shiftDepth);
 
-      var children: [0..#numChildren] Node;
-
       if (numChildren > 0) {
-        c_decompose(parent, c_ptrTo(children), this.treeType, numChildren, this.gen_mx,
-          this.shiftDepth, this.computeGranularity, tree_loc, max_depth);
+        const childType = uts_childType(parent, this.treeType, this.shiftDepth, this.gen_mx);
+
+        for i in 0..#numChildren {
+          var child: Node;
+          c_generateChild(parent, child, childType, i:c_int, this.computeGranularity);
+          children.pushBack(child);
+        }
+
+        tree_loc += numChildren;
+        max_depth = max(max_depth, (parent.height + 1):int);
       }
       else {
         num_sol += 1;
       }
-
-      return children;
     }
 
     // No bounding in UTS
@@ -106,6 +111,12 @@ module Problem_UTS
       return 0;
     }
 
+    // all nodes have the same bound
+    override proc getBound(const node): int
+    {
+      return 0;
+    }
+
     // =======================
     // Utility functions
     // =======================
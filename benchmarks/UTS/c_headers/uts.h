@@ -67,8 +67,8 @@ int uts_numChildren(Node_UTS* parent, tree_t treeType, int nonLeafBF, double non
 
 int uts_childType(Node_UTS* parent, tree_t treeType, double shiftDepth, int gen_mx);
 
-void c_decompose(Node_UTS* parent, Node_UTS children[], tree_t treeType, int numChildren,
-  int gen_mx, double shiftDepth, int computeGranularity, int* treeSize, int* maxDepth);
+void c_generateChild(Node_UTS* parent, Node_UTS* child, int childType, int i,
+  int computeGranularity);
 
 #ifdef __cplusplus
 }
@@ -176,23 +176,17 @@ int uts_childType(Node_UTS* parent, tree_t treeType, double shiftDepth, int gen_
   }
 }
 
-void c_decompose(Node_UTS* parent, Node_UTS children[], tree_t treeType, int numChildren,
-  int gen_mx, double shiftDepth, int computeGranularity, int* treeSize, int* maxDepth)
+// Generate the i-th child of 'parent' in place, so that it can be written directly
+// into the pool of the caller.
+void c_generateChild(Node_UTS* parent, Node_UTS* child, int childType, int i,
+  int computeGranularity)
 {
-  int childrenHeight = parent->height + 1;
-  int childType = childType = uts_childType(parent, treeType, shiftDepth, gen_mx);
+  child->dist = childType;
+  child->height = parent->height + 1;
+  child->numChildren = -1;
 
-  for (int i = 0; i < numChildren; i++) {
-    children[i].dist = childType;
-    children[i].height = childrenHeight;
-    children[i].numChildren = -1;
-
-    // 'computeGranularity' controls the number of 'rng_spawn' calls per node evaluation.
-    for (int j = 0; j < computeGranularity; j++) {
-      rng_spawn(parent->state.state, children[i].state.state, i);
-    }
+  // 'computeGranularity' controls the number of 'rng_spawn' calls per node evaluation.
+  for (int j = 0; j < computeGranularity; j++) {
+    rng_spawn(parent->state.state, child->state.state, i);
   }
-
-  *treeSize += numChildren;
-  *maxDepth = MAX(*maxDepth, childrenHeight);
 }
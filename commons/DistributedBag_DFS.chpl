@@ -47,6 +47,27 @@
                       one is no more appropriate, and we steal each segment in order
                       to not create load-unbalance between them.
 
+  Termination is also detected by the data structure itself. A task whose removal
+  fails is marked as idle, and a locale is passive when all its tasks are idle and
+  all its segments are empty. A token circulates among the passive locales following
+  the Dijkstra-Safra scheme: a locale that has been stolen from is colored black, as
+  the thief may have been already visited by the token, and it taints the token when
+  forwarding it. When a white token comes back to a white and passive locale 0, the
+  whole distBag_DFS is empty and all the subsequent removals report it.
+
+  Idle tasks do not spin on their victims: after each failed removal, they back off
+  exponentially, and after a few failures in a row they park until a busy task of
+  their locale publishes work (see :const:`distributedBagIdleParkAfter`). One task
+  per locale always stays awake to keep stealing globally and to handle the token.
+
+  A segment never holds more than :const:`distributedBagMaxSegmentCap` elements in
+  memory. Beyond that, its oldest elements are spilled to a file, in chunks that
+  are read back by its owner at the head, the most recent first, once the segment
+  is drained or when a thief asks for work that the segment has no longer in
+  memory, so that the depth-first order is preserved (see
+  :const:`distributedBagSpillDir`). Elements that are not plain-old-data must
+  define ``writeFields(writer)`` and ``readFields(reader)`` to be spilled.
+
   The data structure scales in terms of nodes, processors per node, and even workload.
   Nevertheless, it does not come without flaws; as WS is dynamic and triggered
   on demand, WS can still be performed in excess, which dramatically causes a
@@ -138,10 +159,12 @@ module DistributedBag_DFS
 {
   public use Collection;
   private use IO;
+  private use CTypes;
+  private import FileSystem;
 
-  use Random;
   use List;
   use Math;
+  private use Reflection;
 
   /*
     The scenarios of the remove operation (See the Implementation Details section).
@@ -162,9 +185,21 @@ module DistributedBag_DFS
     Outputs of the remove operation. They are used to indicate the final status
     of the operation: success or fail.
   */
-  private param REMOVE_SUCCESS   =  1;
-  private param REMOVE_FAST_EXIT =  0;
-  private param REMOVE_FAIL      = -1;
+  private param REMOVE_SUCCESS    =  1;
+  private param REMOVE_FAST_EXIT  =  0;
+  private param REMOVE_FAIL       = -1;
+  private param REMOVE_TERMINATED = -2;
+
+  /*
+    Colors of the locales and of the token used for termination detection.
+  */
+  private param WHITE = false;
+  private param BLACK = true;
+
+  /*
+    Load of a locale that has not been published yet (see 'Bag.publishLoad').
+  */
+  private param UNKNOWN_LOAD = -1;
 
   /*
     The initial capacity of each segment. When a segment is full, we double its
@@ -200,6 +235,106 @@ module DistributedBag_DFS
     have a maximum of 125,000 elements stolen at once.
   */
   config const distributedBagWorkStealingMemCap: real = 1.0;
+  /*
+    The number of elements taken from a victim segment by a steal:
+
+      * "one":      a single element, the shallowest;
+      * "half":     half of the shared portion of the victim;
+      * "adaptive": a share of the shared portion of the victim, starting at
+                    :const:`distributedBagWorkStealingRatio` and doubling (up to
+                    half) with each failed removal in a row of the thief, so that
+                    starving tasks take more at once.
+
+    In all cases, at most :const:`distributedBagWorkStealingMemCap` are stolen.
+    The lock-free segments (see :const:`distributedBagLockFree`) only support "one".
+  */
+  config const distributedBagStealPolicy: string = "one";
+  /*
+    The order in which a thief visits the segments of its locale (local steals)
+    and the other locales (global steals):
+
+      * "rand":    random order, drawn from a per-task generator;
+      * "ring":    round-robin order, starting from the thief's neighbour;
+      * "last":    the last victim of a successful steal first, then random;
+      * "richest": the segment with the largest shared portion first, then random
+                   (local steals only; "rand" for global steals);
+      * "hier":    the victims of the thief's group first, then the others, both in
+                   random order (see :const:`distributedBagTasksPerGroup` and
+                   :const:`distributedBagLocalesPerGroup`).
+  */
+  config const distributedBagVictimPolicy: string = "rand";
+  config const distributedBagGlobalVictimPolicy: string = "rand";
+  /*
+    The number of consecutive tasks (resp. locales) forming a group for the "hier"
+    victim policy, typically the number of cores of a socket or NUMA domain (resp.
+    the number of nodes of a switch). Tasks and locales are then assumed to be
+    numbered following the topology. A group spans all of them if set to 0.
+  */
+  config const distributedBagTasksPerGroup: int = 0;
+  config const distributedBagLocalesPerGroup: int = 0;
+  /*
+    The seed of the per-task random generators used to select victims, combined
+    with the locale and task identifiers.
+  */
+  config const distributedBagSeed: int = 1;
+  /*
+    The maximum number of times an idle task yields between two failed removals.
+    This number doubles after each failure, starting from 1.
+  */
+  config const distributedBagIdleBackoffCap: int = 1024;
+  /*
+    The number of failed removals in a row after which an idle task parks until
+    new work is published on its locale. Parking is disabled if set to 0.
+  */
+  config const distributedBagIdleParkAfter: int = 16;
+  /*
+    The minimum number of elements a busy task must hold in the private portion
+    of its segment before it publishes some of them to wake parked tasks up.
+  */
+  config const distributedBagWakeThreshold: int = 2;
+  /*
+    The directory of the files where full segments spill their oldest elements,
+    one file per segment, created on demand.
+  */
+  config const distributedBagSpillDir: string = ".";
+  /*
+    Use the lock-free variant of the owner's operations, in the style of the
+    Chase-Lev deque: the owner inserts, removes, shares and takes back elements
+    without taking any lock, except when it contends with a thief for the last
+    shared element. This is a variant of the same segments, not a separate deque,
+    and it has two limits:
+
+      * the steal path is not lock-free: thieves still serialize on the victim's
+        block lock, which protects the block against growth and spilling, so that
+        the compare-and-swap on the head only arbitrates between a thief and the
+        owner;
+      * thieves steal one element at a time, whatever
+        :const:`distributedBagStealPolicy` is (no steal-half or steal-k).
+  */
+  config param distributedBagLockFree: bool = false;
+  /*
+    Push-based balancing across locales, complementing the global steals: every
+    :const:`distributedBagPushPeriod` removals, a task publishes the number of
+    elements of its locale to the other locales. If its locale holds at least
+    twice :const:`distributedBagPushThreshold` elements, it also donates the
+    shallowest elements of its segment, in bulk, to the locales known to hold
+    fewer than :const:`distributedBagPushThreshold` elements. Donations land in a
+    per-locale inbox, drained by the tasks of the receiving locale before they
+    steal. Disabled if set to 0.
+  */
+  config const distributedBagPushPeriod: int = 0;
+  config const distributedBagPushThreshold: int = 1024;
+  /*
+    The minimum estimated remaining work of the shallowest shared element of a
+    victim segment for a steal to take it alone. The remaining work of an element
+    is the number of levels between its ``depth`` field and the depth of the leaves,
+    given by :proc:`DistributedBagImpl.setMaxDepth`. Below this threshold, the
+    victim is only stolen from in batch (half of its shared portion, at least 2
+    elements), and skipped otherwise, so that thieves turn to victims holding
+    shallower elements. Disabled if set to 0, or if the depth of the leaves or of
+    the elements is unknown.
+  */
+  config const distributedBagStealMinWork: int = 0;
 
   /*
     Reference counter for DistributedBag_DFS.
@@ -212,6 +347,10 @@ module DistributedBag_DFS
 
     proc deinit()
     {
+      // the load publications in flight target the other instances (see 'Bag.publishLoad')
+      coforall loc in Locales do on loc {
+        chpl_getPrivatizedCopy(unmanaged DistributedBagImpl(eltType), _pid).bag!.pendingLoads.waitFor(0);
+      }
       coforall loc in Locales do on loc {
         delete chpl_getPrivatizedCopy(unmanaged DistributedBagImpl(eltType), _pid);
       }
@@ -323,6 +462,9 @@ module DistributedBag_DFS
 
       init this;
 
+      if (distributedBagLockFree && (distributedBagStealPolicy != "one")) then
+        warning("DistributedBag_DFS: the lock-free segments steal one element at a time, `distributedBagStealPolicy` is ignored");
+
       this.pid = _newPrivatizedClass(this);
       this.bag = new unmanaged Bag(eltType, this);
     }
@@ -391,10 +533,23 @@ module DistributedBag_DFS
       return bag!.addBulk(elts, taskId);
     }
 
+    /*
+      Obtain a handle on the calling task's segment of this node's bag. Elements
+      passed to its `pushBack` method are written directly at the tail of the
+      segment, which avoids building a temporary collection before calling
+      :proc:`addBulk`.
+    */
+    proc sink(taskId: int): segmentSink(eltType)
+    {
+      return new segmentSink(eltType, bag!, taskId);
+    }
+
     /*
       Remove an element from the calling thread's segment of this node's bag.
       If the thread's segment is empty, it will attempt to steal an element from
-      the segment of another thread or node.
+      the segment of another thread or node. The first component of the returned
+      tuple is 1 on success, 0 or -1 if the removal failed but elements may still
+      arrive, and -2 once the whole distBag_DFS is empty and all the tasks are idle.
     */
     proc remove(taskId: int): (int, eltType)
     {
@@ -407,7 +562,135 @@ module DistributedBag_DFS
       the removed element on success.
     */
 
-    // TODO: implement 'removeBulk'.
+    /*
+      Remove up to ``elts.size`` elements from the calling thread's segment of this
+      node's bag, without stealing, and store them in ``elts``. Elements are only
+      taken if the private portion of the segment holds at least ``elts.size`` of
+      them; otherwise, nothing is removed and :proc:`remove` is to be used. Return
+      the number of elements removed.
+    */
+    proc removeBulk(taskId: int, ref elts: [] eltType): int
+    {
+      return bag!.removeBulk(taskId, elts);
+    }
+
+    /*
+      Check if termination has been detected (see :proc:`remove`).
+    */
+    proc isTerminated(): bool
+    {
+      return bag!.terminated.read();
+    }
+
+    /*
+      Stop all the tasks, on all the locales: subsequent removals report the
+      termination, even though elements remain in this distBag_DFS.
+    */
+    proc stop(): void
+    {
+      bag!.announceTermination();
+    }
+
+    /*
+      Set the depth of the leaves of the search tree, on all the locales, used to
+      estimate the remaining work below an element (see
+      :const:`distributedBagStealMinWork`). 0 if unknown.
+    */
+    proc setMaxDepth(const maxDepth: int): void
+    {
+      coforall loc in targetLocales do on loc {
+        var instance = getPrivatizedThis;
+        instance.bag!.maxDepth = maxDepth;
+      }
+    }
+
+    /*
+      Obtain the number of parked tasks of this node's bag.
+    */
+    proc getParkedTasks(): int
+    {
+      return bag!.nParked.read();
+    }
+
+    /*
+      Obtain statistics on this node's bag, for monitoring purposes. No lock is
+      taken, so that the values are approximate under concurrent operations.
+    */
+    proc getLocalStats(): poolStats
+    {
+      var stats: poolStats;
+
+      for taskId in 0..#here.maxTaskPar {
+        ref segment = bag!.segments[taskId];
+
+        stats.size += segment.nElts + segment.nSpilled;
+        stats.localStealAttempts += segment.nLocalStealAttempts.read(memoryOrder.relaxed);
+        stats.localSteals += segment.nLocalSteals.read(memoryOrder.relaxed);
+        stats.globalStealAttempts += segment.nGlobalStealAttempts.read(memoryOrder.relaxed);
+        stats.globalSteals += segment.nGlobalSteals.read(memoryOrder.relaxed);
+      }
+      stats.size += bag!.nInbox.read(memoryOrder.relaxed);
+      stats.idleTasks = bag!.nIdleTasks.read(memoryOrder.relaxed);
+      stats.parkedTasks = bag!.nParked.read(memoryOrder.relaxed);
+
+      return stats;
+    }
+
+    /*
+      Write the elements of this node's bag into `writer`, in binary format: the
+      number of segments, then the number of elements of each segment followed by
+      their raw bytes. Elements must be plain-old-data, and the tasks using the bag
+      are expected to be paused.
+    */
+    proc writeLocal(writer): void throws
+    {
+      if !isPODType(eltType) then
+        halt("DistributedBag_DFS: only plain-old-data elements can be written");
+
+      // the inbox is written as an additional segment (see 'Bag.pushWork')
+      writer.writeBinary(here.maxTaskPar + 1);
+
+      for taskId in 0..#here.maxTaskPar {
+        ref segment = bag!.segments[taskId];
+
+        segment.lock_block.readFE();
+        const n = segment.nElts;
+        writer.writeBinary(n + segment.nSpilled);
+        segment.block.writeElements(writer, segment.block.headId, n);
+        segment.copySpill(writer);
+        segment.lock_block.writeEF(true);
+      }
+
+      var donated = bag!.inboxSnapshot();
+
+      writer.writeBinary(donated.size);
+      if (donated.size > 0) then
+        writer.writeBinary(c_ptrTo(donated[0]), donated.size * c_sizeof(eltType):int);
+    }
+
+    /*
+      Read elements written by :proc:`writeLocal` from `reader`, and insert them in
+      this node's bag. The number of segments may differ from the one of the writer.
+    */
+    proc readLocal(reader): void throws
+    {
+      if !isPODType(eltType) then
+        halt("DistributedBag_DFS: only plain-old-data elements can be read");
+
+      var numSegments: int;
+      reader.readBinary(numSegments);
+
+      for i in 0..#numSegments {
+        var n: int;
+        reader.readBinary(n);
+
+        var buffer: [0..#n] eltType;
+        if (n > 0) then
+          reader.readBinary(c_ptrTo(buffer[0]), n * c_sizeof(eltType):int);
+
+        bag!.addBulk(buffer, i % here.maxTaskPar);
+      }
+    }
 
     /*
       Obtain the number of elements held in this distBag_DFS.
@@ -427,7 +710,8 @@ module DistributedBag_DFS
       coforall loc in targetLocales do on loc {
         var instance = getPrivatizedThis;
         forall taskId in 0..#here.maxTaskPar do
-          size.add(instance.bag!.segments[taskId].nElts);
+          size.add(instance.bag!.segments[taskId].nElts + instance.bag!.segments[taskId].nSpilled);
+        size.add(instance.bag!.nInbox.read());
       }
 
       return size.read();
@@ -470,6 +754,11 @@ module DistributedBag_DFS
     */
     override proc clear(): void
     {
+      // so that no load publication in flight lands after the reset below
+      coforall loc in targetLocales do on loc {
+        getPrivatizedThis.bag!.pendingLoads.waitFor(0);
+      }
+
       coforall loc in targetLocales do on loc {
         var instance = getPrivatizedThis;
         forall taskId in 0..#here.maxTaskPar {
@@ -488,10 +777,22 @@ module DistributedBag_DFS
           segment.lock_n.writeXF(true);
           segment.tail = 0;
           segment.o_split = 0;
+          segment.idle = false;
+          segment.nFails = 0;
+          segment.nRemoves = 0;
+          segment.spillChunks.clear();
+          segment.spillOffsets.clear();
+          segment.spillBytes = 0;
+          segment.nSpilled = 0;
 
           segment.lock_block.writeEF(true);
         }
+        instance.bag!.inbox.clear();
+        instance.bag!.nInbox.write(0);
+        for load in instance.bag!.loads do load.write(UNKNOWN_LOAD);
+        instance.bag!.publishedLoad.write(UNKNOWN_LOAD);
         instance.bag!.globalStealInProgress.write(false);
+        instance.bag!.resetTermination();
       }
     }
 
@@ -527,19 +828,29 @@ module DistributedBag_DFS
           on loc {
             ref segment = getPrivatizedThis.bag!.segments[taskId];
 
-            segment.lock_block.readFE();
-            // Create a snapshot
-            dom = {0..#segment.nElts};
-            for i in dom {
-              buffer[i] = segment.block.elts[segment.block.headId + i];
-            }
-            segment.lock_block.writeEF(true);
+            // Create a snapshot, including the spilled elements
+            const snapshot = segment.snapshot();
+            dom = snapshot.domain;
+            buffer = snapshot;
           }
           // Process this chunk if we have one...
           foreach elt in buffer {
             yield elt;
           }
         }
+
+        // The donations not yet drained by the tasks of this locale
+        var dom: domain(1) = {0..-1};
+        var buffer: [dom] eltType;
+
+        on loc {
+          const donated = getPrivatizedThis.bag!.inboxSnapshot();
+          dom = donated.domain;
+          buffer = donated;
+        }
+        foreach elt in buffer {
+          yield elt;
+        }
       }
     }
 
@@ -551,18 +862,18 @@ module DistributedBag_DFS
         coforall taskId in 0..#here.maxTaskPar {
           ref segment = instance.bag!.segments[taskId];
 
-          segment.lock_block.readFE();
-          // Create a snapshot
-          var bufferSize = segment.nElts;
-          var buffer: [0..#bufferSize] eltType;
-          for i in 0..#bufferSize {
-            buffer[i] = segment.block.elts[segment.block.headId + i];
-          }
-          segment.lock_block.writeEF(true);
+          // Create a snapshot, including the spilled elements
+          var buffer = segment.snapshot();
+          var bufferSize = buffer.size;
 
           // Yield this chunk
           yield (bufferSize, buffer);
         }
+
+        // The donations not yet drained by the tasks of this locale
+        var buffer = instance.bag!.inboxSnapshot();
+        var bufferSize = buffer.size;
+        yield (bufferSize, buffer);
       }
     }
 
@@ -576,6 +887,21 @@ module DistributedBag_DFS
     }
   } // end 'DistributedBagImpl' class
 
+  /*
+    Iterate over a random permutation of 0..#N derived from 'rnd', without any
+    allocation: a random start and a random stride coprime with N.
+  */
+  private iter randomOrder(const N: int, const rnd: uint): int
+  {
+    if (N <= 0) then return;
+
+    const start = (rnd % N:uint):int;
+    var stride = 1 + ((rnd >> 32) % N:uint):int;
+    while (gcd(stride, N) != 1) do stride -= 1;
+
+    for i in 0..#N do yield (start + i*stride) % N;
+  }
+
   /*
     We maintain a multi-pool 'bag' per locale. Each bag keeps a handle to its parent,
     which is required for work stealing.
@@ -591,6 +917,35 @@ module DistributedBag_DFS
     var segments: [0..#here.maxTaskPar] Segment(eltType);
 
     var globalStealInProgress: atomic bool = false;
+    // last victim locale of a successful global steal (see 'victim'), protected
+    // by 'globalStealInProgress'
+    var lastGlobalVictim: int = -1;
+
+    // Termination detection (see 'detectTermination')
+    var nIdleTasks: atomic int;
+    var activations: atomic int; // number of idle-to-busy transitions
+    var hasToken: atomic bool = (here.id == 0);
+    var tokenColor: atomic bool = WHITE;
+    var localeColor: atomic bool = WHITE;
+    var roundStarted: bool = false; // only used by locale 0
+    var terminated: atomic bool = false;
+
+    // Idle policy (see 'idleWait')
+    var nParked: atomic int;
+
+    // depth of the leaves of the search tree, if known (see 'remainingWork')
+    var maxDepth: int = 0;
+
+    // Push-based balancing (see 'pushWork'): elements donated by other locales,
+    // and last known number of elements of each locale, 'UNKNOWN_LOAD' until
+    // the locale publishes it
+    var inbox: list(eltType);
+    var nInbox: atomic int;
+    var lock_inbox: sync bool = true;
+    var loads: [0..#numLocales] atomic int;
+    var publishedLoad: atomic int;
+    var pendingLoads: atomic int; // publications in flight (see 'publishLoad')
+    var pushInProgress: atomic bool = false;
 
     proc init(type eltType, parentHandle)
     {
@@ -600,10 +955,23 @@ module DistributedBag_DFS
       // array (see Github issue #19859).
     }
 
+    proc postinit()
+    {
+      for taskId in 0..#here.maxTaskPar {
+        segments[taskId].spillPath = distributedBagSpillDir + "/distbag_spill_" +
+          parentHandle.pid:string + "_" + here.id:string + "_" + taskId:string + ".bin";
+        segments[taskId].seedRandom(distributedBagSeed:uint, (here.id * here.maxTaskPar + taskId):uint);
+      }
+      for load in loads do load.write(UNKNOWN_LOAD);
+      publishedLoad.write(UNKNOWN_LOAD);
+    }
+
     proc deinit()
     {
-      forall segment in segments do
+      forall segment in segments {
         delete segment.block;
+        segment.closeSpill();
+      }
     }
 
     /*
@@ -611,7 +979,12 @@ module DistributedBag_DFS
     */
     proc add(elt: eltType, const taskId: int): bool
     {
-      return segments[taskId].addElement(elt);
+      ref segment = segments[taskId];
+      const added = segment.addElement(elt);
+
+      if (nParked.read() > 0) then publishWork(segment);
+
+      return added;
     }
 
     /*
@@ -619,20 +992,260 @@ module DistributedBag_DFS
     */
     proc addBulk(elts, const taskId: int): int
     {
-      return segments[taskId].addElements(elts);
+      ref segment = segments[taskId];
+      const size = segment.addElements(elts);
+
+      if (nParked.read() > 0) then publishWork(segment);
+
+      return size;
+    }
+
+    /*
+      Move part of the private portion of ``segment`` to its shared portion, and
+      wake as many parked tasks up. Only called by the owner, when some tasks of
+      the locale are parked.
+    */
+    proc publishWork(ref segment: Segment(eltType)): void
+    {
+      if (segment.nElts_private < distributedBagWakeThreshold) then return;
+
+      segment.split_release();
+      wakeIdle(segment.nElts_shared.read());
+    }
+
+    /*
+      Wake up to ``n`` parked tasks of this locale.
+    */
+    proc wakeIdle(const n: int): void
+    {
+      var count: int = 0;
+
+      for taskId in 0..#here.maxTaskPar {
+        if ((count >= n) || (nParked.read() == 0)) then return;
+
+        ref targetSegment = segments[taskId];
+
+        if targetSegment.parked.compareAndSwap(true, false) {
+          nParked.sub(1);
+          targetSegment.parkSignal.writeEF(true);
+          count += 1;
+        }
+      }
+    }
+
+    /*
+      Idle policy, applied after a failed removal: yield an exponentially growing
+      number of times, then park once the task failed too many times in a row. At
+      most 'here.maxTaskPar - 1' tasks can be parked, so that one task per locale
+      keeps stealing globally and detecting termination.
+    */
+    proc idleWait(ref segment: Segment(eltType)): void
+    {
+      segment.nFails += 1;
+
+      if ((distributedBagIdleParkAfter > 0) && (segment.nFails > distributedBagIdleParkAfter)) {
+        if (nParked.fetchAdd(1) < here.maxTaskPar - 1) {
+          park(segment);
+          return;
+        }
+        nParked.sub(1);
+      }
+
+      const n = min(distributedBagIdleBackoffCap, 1 << min(segment.nFails - 1, 30));
+      for 1..n do currentTask.yieldExecution();
+    }
+
+    /*
+      Block the owner of ``segment`` until another task wakes it up. The task has
+      already been counted in 'nParked'.
+    */
+    @chpldoc.nodoc
+    proc park(ref segment: Segment(eltType)): void
+    {
+      segment.parked.write(true);
+
+      // check again, as work may have been published before we were visible
+      var hasWork = (terminated.read() || (nInbox.read() > 0));
+      for taskId in 0..#here.maxTaskPar {
+        if (segments[taskId].nElts_shared.read() > 0) then hasWork = true;
+      }
+
+      if hasWork {
+        if segment.parked.compareAndSwap(true, false) {
+          nParked.sub(1);
+          return;
+        }
+        // a concurrent wake up is in progress, consume its signal below
+      }
+
+      segment.parkSignal.readFE();
+    }
+
+    /*
+      Mark the task owning ``segment`` as idle. Only called by the owner, holding
+      no element.
+    */
+    inline proc markIdle(ref segment: Segment(eltType)): void
+    {
+      if !segment.idle {
+        segment.idle = true;
+        nIdleTasks.add(1);
+      }
+    }
+
+    /*
+      Mark the task owning ``segment`` as busy. When the task got its element by
+      stealing, this must happen before the victim segment is unlocked, so that
+      the element is never invisible to 'isPassive'.
+    */
+    inline proc markBusy(ref segment: Segment(eltType)): void
+    {
+      if segment.idle {
+        segment.idle = false;
+        segment.nFails = 0;
+        activations.add(1);
+        nIdleTasks.sub(1);
+      }
+    }
+
+    /*
+      Check if this locale is passive, i.e. all its tasks are idle and all its
+      segments are empty. Since tasks only produce elements while busy, the
+      segments cannot be refilled in our back as long as no task became busy
+      during the scan.
+    */
+    proc isPassive(): bool
+    {
+      const numTasks = here.maxTaskPar;
+      const act = activations.read();
+
+      if (nIdleTasks.read() != numTasks) then return false;
+
+      for taskId in 0..#numTasks {
+        ref segment = segments[taskId];
+
+        segment.lock_block.readFE();
+        const n = segment.nElts + segment.nSpilled;
+        segment.lock_block.writeEF(true);
+
+        if (n > 0) then return false;
+      }
+
+      lock_inbox.readFE();
+      const nDonated = inbox.size;
+      lock_inbox.writeEF(true);
+
+      if (nDonated > 0) then return false;
+
+      return ((nIdleTasks.read() == numTasks) && (activations.read() == act));
+    }
+
+    /*
+      Termination detection, following the Dijkstra-Safra token ring. It is called
+      by idle tasks; only the one that grabs the token does something, and only if
+      its locale is passive. The token then goes to the next locale, carrying the
+      black color if this locale has been stolen from since the token last left it.
+      Locale 0 starts a new round, unless the token comes back white while it is
+      itself white, in which case termination is announced to all the locales.
+    */
+    proc detectTermination(): void
+    {
+      if !hasToken.read() then return;
+      if !hasToken.compareAndSwap(true, false) then return;
+
+      if !isPassive() {
+        hasToken.write(true);
+        return;
+      }
+
+      const myColor = localeColor.exchange(WHITE);
+      const color = (tokenColor.read() || myColor);
+
+      if (here.id == 0) {
+        if ((numLocales == 1) || (roundStarted && (color == WHITE))) {
+          announceTermination();
+          return;
+        }
+
+        roundStarted = true;
+        forwardToken(1, WHITE);
+      }
+      else {
+        forwardToken((here.id + 1) % numLocales, color);
+      }
+    }
+
+    @chpldoc.nodoc
+    proc forwardToken(const locId: int, const color: bool): void
+    {
+      const parentPid = parentHandle.pid;
+
+      on Locales[locId] {
+        var targetBag = chpl_getPrivatizedCopy(parentHandle.type, parentPid).bag;
+        targetBag!.tokenColor.write(color);
+        targetBag!.hasToken.write(true);
+      }
+    }
+
+    @chpldoc.nodoc
+    proc announceTermination(): void
+    {
+      const parentPid = parentHandle.pid;
+
+      coforall loc in Locales do on loc {
+        var targetBag = chpl_getPrivatizedCopy(parentHandle.type, parentPid).bag;
+        targetBag!.terminated.write(true);
+        targetBag!.wakeIdle(here.maxTaskPar);
+      }
+    }
+
+    @chpldoc.nodoc
+    proc resetTermination(): void
+    {
+      nIdleTasks.write(0);
+      hasToken.write(here.id == 0);
+      tokenColor.write(WHITE);
+      localeColor.write(WHITE);
+      roundStarted = false;
+      terminated.write(false);
+    }
+
+    /*
+      Report the failure of a removal, or the termination if it has been detected.
+    */
+    proc failRemove(ref segment: Segment(eltType)): (int, eltType)
+    {
+      var default: eltType;
+
+      markIdle(segment);
+      detectTermination();
+
+      if terminated.read() then return (REMOVE_TERMINATED, default);
+
+      idleWait(segment);
+
+      return (REMOVE_FAIL, default);
     }
 
     /*
       Iterate over the segments/locales eligible to be stolen from, according to
-      the specified policy. By default, the random strategy is chosen and the
-      calling task/locale cannot be chosen. We can also specify how many victims
-      to check for eligibility; 1 by default.
+      the specified policy (see :const:`distributedBagVictimPolicy`), starting with
+      ``first`` if it is a valid victim. The calling task/locale cannot be chosen.
+      Random orders are derived from ``rnd`` without any allocation. We can also
+      specify how many victims to check for eligibility; 1 by default.
     */
     iter victim(const N: int, const callerId: int, const policy: string = "rand",
-      const tries: int = 1): int
+      const tries: int = 1, const rnd: uint = 0, const first: int = -1,
+      const groupSize: int = 0): int
     {
       var count: int;
       var limit: int = if (callerId == -1) then N else N-1;
+      const hasFirst = ((first >= 0) && (first < N) && (first != callerId));
+
+      if hasFirst {
+        yield first;
+        count += 1;
+      }
 
       select policy {
         // In the 'ring' strategy, victims are selected in a round-robin fashion.
@@ -640,22 +1253,37 @@ module DistributedBag_DFS
           var id = (callerId + 1) % N;
 
           while ((count < limit) && (count < tries)) {
-            yield id;
-            count += 1;
+            if (!hasFirst || (id != first)) {
+              yield id;
+              count += 1;
+            }
             id = (id + 1) % N;
           }
         }
         // In the 'rand' strategy, victims are randomly selected.
-        when "rand" {
-          var id: int;
-          const victims = permute(0..#N);
-
-          while ((count < limit) && (count < tries)) {
-            if (victims[id] != callerId) {
-              yield victims[id];
+        when "rand", "last", "richest" {
+          for id in randomOrder(N, rnd) {
+            if ((count >= limit) || (count >= tries)) then break;
+            if ((id != callerId) && (!hasFirst || (id != first))) {
+              yield id;
               count += 1;
             }
-            id += 1;
+          }
+        }
+        // In the 'hier' strategy, victims of the caller's group are visited first.
+        when "hier" {
+          const g = if ((groupSize <= 0) || (callerId == -1)) then N else groupSize;
+          const myGroup = max(0, callerId) / g;
+
+          for sameGroup in (true, false) {
+            for id in randomOrder(N, rnd) {
+              if ((count >= limit) || (count >= tries)) then break;
+              if (((id / g == myGroup) == sameGroup) && (id != callerId) &&
+                  (!hasFirst || (id != first))) {
+                yield id;
+                count += 1;
+              }
+            }
           }
         }
         otherwise halt("DistributedBag_DFS internal error: Unknown victim choice policy");
@@ -664,32 +1292,268 @@ module DistributedBag_DFS
     /*
       TODO: Probably better to use an enum Policy instead of string here.
     */
+
     /*
-      TODO: Create a seed here for the RNG that includes the locale ID. Since we aren't
-      specifying the seed, we get one based on the time, but this might lead multiple
-      locales running this in parallel choosing the same permutation.
+      Preferred first victim of a local steal by the owner of ``segment``, according
+      to :const:`distributedBagVictimPolicy`, or -1.
     */
+    proc localVictimHint(const ref segment: Segment(eltType), const taskId: int): int
+    {
+      select distributedBagVictimPolicy {
+        when "last" do return segment.lastVictim;
+        when "richest" {
+          // racy reads of the shared portions, used as hints only
+          var (richest, most) = (-1, 0);
+          for i in 0..#here.maxTaskPar {
+            const n = segments[i].nElts_shared.read(memoryOrder.relaxed);
+            if ((i != taskId) && (n > most)) then (richest, most) = (i, n);
+          }
+          return richest;
+        }
+        otherwise do return -1;
+      }
+    }
+
     /*
-      TODO: Computing the permutation as an array seems pretty heavy-weight if we
-      are only going to try 1 segment. For tries < N, it might be better to create
-      a random stream and get bounded numbers with getNext with min and max arguments;
-      and then just accept that the same candidate might be checked multiple times.
-      If the iteration is bounded by limit, then indeed it might be necessary to
-      compute the permutation to ensure that each segment is visited. I suppose
-      it could do some random searching and then a round-robin strategy to make
-      sure each is visited.
+      Maximum number of elements moved at once between segments (see
+      :const:`distributedBagWorkStealingMemCap`).
     */
+    inline proc maxTransferElts(): int
+    {
+      return max(1, (distributedBagWorkStealingMemCap * 1024 * 1024 /
+        c_sizeof(eltType):real): int);
+    }
 
     /*
-      Remove an element from segment ``taskId``. The order in which elements are
-      removed is guaranteed to be the same order they have been inserted. If the
-      best case fails, it trigger a work stealing mechanism (See the Implementation
-      Details section).
+      Number of elements held by this locale, read without locking.
     */
-    proc remove(const taskId: int): (int, eltType)
+    proc localLoad(): int
     {
-      var phase = REMOVE_BEST_CASE;
-      if (numLocales > 1) then phase = PERFORMANCE_PATCH;
+      var load = nInbox.read();
+      for taskId in 0..#here.maxTaskPar do
+        load += segments[taskId].nElts + segments[taskId].nSpilled;
+
+      return load;
+    }
+
+    /*
+      Make the number of elements of this locale known to the other locales, with
+      fire-and-forget writes, so that the calling task does not wait for them.
+    */
+    proc publishLoad(const load: int): void
+    {
+      const parentPid = parentHandle.pid;
+      const myId = here.id;
+
+      publishedLoad.write(load);
+      loads[myId].write(load);
+
+      for loc in Locales {
+        if (loc == here) then continue;
+
+        pendingLoads.add(1);
+        begin on loc {
+          var targetBag = chpl_getPrivatizedCopy(parentHandle.type, parentPid).bag;
+          targetBag!.loads[myId].write(load);
+          pendingLoads.sub(1);
+        }
+      }
+    }
+
+    /*
+      Push-based balancing (see :const:`distributedBagPushPeriod`), called by the
+      owner of ``segment`` while it is busy. Only one task per locale runs it at
+      a time.
+    */
+    proc pushWork(ref segment: Segment(eltType)): void
+    {
+      if !pushInProgress.compareAndSwap(false, true) then return;
+
+      const load = localLoad();
+      publishLoad(load);
+
+      if (load >= 2 * distributedBagPushThreshold) {
+        for locId in victim(numLocales, here.id, "rand", numLocales, segment.nextRandom()) {
+          // only donate to the locales known to be starving
+          const targetLoad = loads[locId].read();
+          if ((targetLoad == UNKNOWN_LOAD) || (targetLoad >= distributedBagPushThreshold)) then continue;
+
+          // donate the shallowest elements, taken from our own shared portion
+          if (segment.nElts_shared.read() < 2) then segment.split_release();
+          const nShared = segment.nElts_shared.read();
+          if (nShared == 0) then break;
+
+          var elts: [0..#(if distributedBagLockFree then 1 else max(1, min(nShared / 2, maxTransferElts())))] eltType;
+          segment.lock_block.readFE();
+          const n = segment.stealElements(elts);
+          segment.lock_block.writeEF(true);
+
+          if (n == 0) then break;
+
+          // the token may have already visited the receiver (see 'detectTermination')
+          localeColor.write(BLACK);
+          donate(locId, elts[0..#n]);
+          // until the receiver publishes its load again
+          loads[locId].add(n);
+        }
+      }
+
+      pushInProgress.write(false);
+    }
+
+    /*
+      Send ``elts`` to the inbox of locale ``locId``, in one bulk transfer, and wake
+      its parked tasks up.
+    */
+    @chpldoc.nodoc
+    proc donate(const locId: int, const elts: [] eltType): void
+    {
+      const parentPid = parentHandle.pid;
+
+      on Locales[locId] {
+        const buffer = elts;
+        var targetBag = chpl_getPrivatizedCopy(parentHandle.type, parentPid).bag;
+
+        targetBag!.lock_inbox.readFE();
+        targetBag!.inbox.pushBack(buffer);
+        targetBag!.nInbox.add(buffer.size);
+        targetBag!.lock_inbox.writeEF(true);
+
+        targetBag!.wakeIdle(buffer.size);
+      }
+    }
+
+    /*
+      Copy of the elements donated to this locale and not yet drained.
+    */
+    proc inboxSnapshot(): [] eltType
+    {
+      lock_inbox.readFE();
+      var donated = inbox.toArray();
+      lock_inbox.writeEF(true);
+
+      return donated;
+    }
+
+    /*
+      Take a fair share of the inbox into ``segment``, and return one of these
+      elements. Only called by the owner of ``segment``.
+    */
+    proc takeDonations(ref segment: Segment(eltType)): (bool, eltType)
+    {
+      var default: eltType;
+
+      lock_inbox.readFE();
+      const size = inbox.size;
+      if (size == 0) {
+        lock_inbox.writeEF(true);
+        return (false, default);
+      }
+
+      const n = (size + here.maxTaskPar - 1) / here.maxTaskPar;
+      var elts: [0..#n] eltType;
+      for i in 0..#n do elts[i] = inbox.popBack();
+      nInbox.sub(n);
+      // before unlocking, so that the elements are never invisible to 'isPassive'
+      markBusy(segment);
+      lock_inbox.writeEF(true);
+
+      if (n > 1) {
+        segment.addElements(elts[0..#(n-1)]);
+        if (nParked.read() > 0) then publishWork(segment);
+      }
+
+      return (true, elts[n-1]);
+    }
+
+    /*
+      Estimated remaining work below ``elt``: the number of levels down to the
+      leaves, if both depths are known, ``max(int)`` otherwise.
+    */
+    inline proc remainingWork(const ref elt: eltType): int
+    {
+      if hasField(eltType, "depth") {
+        if (maxDepth > 0) then return maxDepth - elt.depth: int;
+      }
+
+      return max(int);
+    }
+
+    /*
+      Number of elements to steal from ``targetSegment`` by a thief that failed
+      ``nFails`` removals in a row, holding the victim's block lock: the steal
+      policy's amount, unless its shallowest shared element is estimated to bring
+      too little work (see :const:`distributedBagStealMinWork`). 0 if the victim is
+      not eligible.
+    */
+    proc stealCount(const ref targetSegment: Segment(eltType), const nFails: int): int
+    {
+      const nShared = targetSegment.nElts_shared.read();
+
+      if (nShared < distributedBagWorkStealingMinElts) then return 0;
+      if (nShared == 0) then return 0;
+
+      if ((distributedBagStealMinWork > 0) &&
+          (remainingWork(targetSegment.block[targetSegment.block.headId]) < distributedBagStealMinWork)) {
+        if (distributedBagLockFree || (nShared < 4)) then return 0;
+        return max(stealAmount(nShared, nFails), min(nShared / 2, maxTransferElts()));
+      }
+
+      return stealAmount(nShared, nFails);
+    }
+
+    /*
+      Number of elements to steal from a victim segment whose shared portion holds
+      ``nShared`` elements, by a thief that failed ``nFails`` removals in a row (see
+      :const:`distributedBagStealPolicy`).
+    */
+    proc stealAmount(const nShared: int, const nFails: int): int
+    {
+      if distributedBagLockFree then return 1;
+
+      const maxElts = maxTransferElts();
+      var n: int;
+
+      select distributedBagStealPolicy {
+        when "one" do n = 1;
+        when "half" do n = nShared / 2;
+        when "adaptive" {
+          const ratio = min(0.5, distributedBagWorkStealingRatio * 2**min(nFails, 8));
+          n = (nShared * ratio): int;
+        }
+        otherwise halt("DistributedBag_DFS: unknown steal policy ", distributedBagStealPolicy);
+      }
+
+      return max(1, min(n, maxElts));
+    }
+
+    /*
+      Remove elements in bulk from the private portion of segment ``taskId`` (see
+      :proc:`DistributedBagImpl.removeBulk`).
+    */
+    proc removeBulk(const taskId: int, ref elts: [] eltType): int
+    {
+      ref segment = segments[taskId];
+
+      if terminated.read(memoryOrder.relaxed) then return 0;
+      if (segment.nElts_private < elts.size) then return 0;
+
+      const n = segment.takeElements(elts);
+      if (nParked.read() > 0) then publishWork(segment);
+
+      return n;
+    }
+
+    /*
+      Remove an element from segment ``taskId``. The order in which elements are
+      removed is guaranteed to be the same order they have been inserted. If the
+      best case fails, it trigger a work stealing mechanism (See the Implementation
+      Details section).
+    */
+    proc remove(const taskId: int): (int, eltType)
+    {
+      var phase = REMOVE_BEST_CASE;
+      if (numLocales > 1) then phase = PERFORMANCE_PATCH;
 
       ref segment = segments[taskId];
       var default: eltType;
@@ -711,12 +1575,30 @@ module DistributedBag_DFS
                        simply get a element.
           */
           when REMOVE_BEST_CASE {
-            // if the private region contains at least one element to be removed...
-            if (segment.nElts_private > 0) {
+            // the search may have been stopped (see 'DistributedBagImpl.stop')
+            if terminated.read(memoryOrder.relaxed) then return (REMOVE_TERMINATED, default);
+
+            // reload spilled elements, into the shared portion, once the segment is
+            // drained, or when a thief is waiting and there is nothing left to
+            // share (the spill tier is only reachable through the owner)
+            if ((segment.nSpilled > 0) && (segment.nElts_shared.read() == 0) &&
+                ((segment.nElts_private == 0) ||
+                 (segment.split_request.read() && (segment.nElts_private <= 1)))) then
+              segment.unspill();
+
+            // if the segment contains at least one element to be removed (the
+            // owner takes back its shared elements once its private region is empty)...
+            if ((segment.nElts_private > 0) || (segment.nElts_shared.read() > 0)) {
               // attempt to remove an element
               var (hasWork, elt): (bool, eltType) = segment.takeElement();
 
-              if hasWork then return (REMOVE_SUCCESS, elt);
+              if hasWork {
+                if (nParked.read() > 0) then publishWork(segment);
+                segment.nRemoves += 1;
+                if ((distributedBagPushPeriod > 0) && (numLocales > 1) &&
+                    (segment.nRemoves % distributedBagPushPeriod == 0)) then pushWork(segment);
+                return (REMOVE_SUCCESS, elt);
+              }
               /* if hasWork then return (1, elt);
               else return (-1, default); */
             }
@@ -746,25 +1628,48 @@ module DistributedBag_DFS
               return (REMOVE_FAST_EXIT, default);
             }
 
+            if terminated.read() then return (REMOVE_TERMINATED, default);
+
+            // elements donated by other locales come first (see 'pushWork')
+            if (nInbox.read() > 0) {
+              const (hasWork, elt) = takeDonations(segment);
+              if hasWork then return (REMOVE_SUCCESS, elt);
+            }
+
+            segment.nLocalStealAttempts.add(1, memoryOrder.relaxed);
+
             // selection of the victim segment
-            for victimTaskId in victim(here.maxTaskPar, taskId, "rand", here.maxTaskPar) {
+            for victimTaskId in victim(here.maxTaskPar, taskId, distributedBagVictimPolicy,
+                here.maxTaskPar, segment.nextRandom(), localVictimHint(segment, taskId),
+                distributedBagTasksPerGroup) {
               ref targetSegment = segments[victimTaskId];
 
               if !targetSegment.globalSteal.read() {
                 targetSegment.lock_block.readFE();
                 // if the shared region contains enough elements to be stolen...
-                if (distributedBagWorkStealingMinElts <= targetSegment.nElts_shared.read()) {
-                  // attempt to steal an element
-                  var (hasElt, elt): (bool, eltType) = targetSegment.stealElement();
-
-                  // if the steal succeeds, we return, otherwise we continue
-                  if hasElt {
+                const nSteal = stealCount(targetSegment, segment.nFails);
+                if (nSteal > 0) {
+                  // attempt to steal elements
+                  var stolenElts: [0..#nSteal] eltType;
+                  const n = targetSegment.stealElements(stolenElts);
+
+                  // if the steal succeeds, we keep all but the newest stolen element
+                  // and return the latter, otherwise we continue
+                  if (n > 0) {
+                    markBusy(segment);
+                    segment.nLocalSteals.add(1, memoryOrder.relaxed);
+                    segment.lastVictim = victimTaskId;
                     targetSegment.lock_block.writeEF(true);
-                    return (REMOVE_SUCCESS, elt);
+                    if (n > 1) {
+                      segment.addElements(stolenElts[0..#(n-1)]);
+                      if (nParked.read() > 0) then publishWork(segment);
+                    }
+                    return (REMOVE_SUCCESS, stolenElts[n-1]);
                   }
                 }
                 // otherwise, if the private region has elements, we request for a split shifting
-                else if (targetSegment.nElts_private > 1) {
+                else if ((targetSegment.nElts_shared.read() < max(1, distributedBagWorkStealingMinElts)) &&
+                         (targetSegment.nElts_private > 1)) {
                   splitreq = true;
                   targetSegment.split_request.write(true);
                 }
@@ -772,6 +1677,8 @@ module DistributedBag_DFS
               }
             }
 
+            segment.lastVictim = -1;
+
             if splitreq then return (REMOVE_FAST_EXIT, default);
 
             phase = REMOVE_GLOBAL_STEAL;
@@ -790,27 +1697,40 @@ module DistributedBag_DFS
           */
           when REMOVE_GLOBAL_STEAL {
             // fast exit for single-node execution
-            if (numLocales == 1) then return (REMOVE_FAIL, default);
+            if (numLocales == 1) then return failRemove(segment);
 
             // lock the global steal operation
             if !globalStealInProgress.compareAndSwap(false, true) {
               return (REMOVE_FAST_EXIT, default);
             }
 
+            segment.nGlobalStealAttempts.add(1, memoryOrder.relaxed);
+
+            // let the other locales know we are starving (see 'pushWork')
+            const myLoad = publishedLoad.read();
+            if ((distributedBagPushPeriod > 0) &&
+                ((myLoad == UNKNOWN_LOAD) || (myLoad >= distributedBagPushThreshold))) then
+              publishLoad(0);
+
             const parentPid = parentHandle.pid;
-            var stolenElts: list(eltType);
-            /*
-              TODO: Such distributed list insertion should not be particularly efficient.
-              The list data type works better if you are appending; inserting at
-              the 0th position is O(n).
-            */
+            const nFails = segment.nFails;
+            const rnd = segment.nextRandom();
+            const lastVictim = if (distributedBagGlobalVictimPolicy == "last") then lastGlobalVictim else -1;
+            var victimId = -1;
+            // buffer receiving the stolen elements, filled in one bulk transfer
+            var stolenDom: domain(1);
+            var stolenElts: [stolenDom] eltType;
 
             // iterate over the victim locales
-            for victimLocaleId in victim(numLocales, here.id, "rand", 1) {
+            for victimLocaleId in victim(numLocales, here.id, distributedBagGlobalVictimPolicy, 1,
+                rnd, lastVictim, distributedBagLocalesPerGroup) {
+              victimId = victimLocaleId;
               on Locales[victimLocaleId] {
                 var targetBag = chpl_getPrivatizedCopy(parentHandle.type, parentPid).bag;
+                // the stolen elements are gathered locally first
+                var localElts: list(eltType);
                 // iterate over the victim tasks
-                for victimTaskId in victim(here.maxTaskPar, -1, "rand", here.maxTaskPar) {
+                for victimTaskId in victim(here.maxTaskPar, -1, "rand", here.maxTaskPar, rnd >> 17) {
                   ref targetSegment = targetBag!.segments[victimTaskId];
 
                   targetSegment.globalSteal.write(true);
@@ -818,34 +1738,47 @@ module DistributedBag_DFS
                   //var sharedElts: int = targetSegment.nElems_shared.read();
                   // if the shared region contains enough elements to be stolen...
                   targetSegment.lock_block.readFE();
-                  if (1 < targetSegment.nElts_shared.read()) {
-                    //for i in 0..#(targetSegment.nElems_shared.read()/2):int {
-                      // attempt to steal an element
-                      var (hasElt, elt): (bool, eltType) = targetSegment.stealElement();
-
-                      // if the steal succeeds...
-                      if hasElt {
-                        stolenElts.insert(0, elt);
-                      }
-                  //  }
+                  const nSteal = if (1 < targetSegment.nElts_shared.read())
+                    then targetBag!.stealCount(targetSegment, nFails) else 0;
+                  if (nSteal > 0) {
+                    // the token may have already visited us (see 'detectTermination')
+                    targetBag!.localeColor.write(BLACK);
+
+                    // attempt to steal elements
+                    var elts: [0..#nSteal] eltType;
+                    const n = targetSegment.stealElements(elts);
+
+                    // if the steal succeeds...
+                    if (n > 0) then localElts.pushBack(elts[0..#n]);
                   }
-                  else if (targetSegment.nElts_private > 1) {
+                  else if ((targetSegment.nElts_shared.read() <= 1) && (targetSegment.nElts_private > 1)) {
                     targetSegment.split_request.write(true);
                   }
 
                   targetSegment.lock_block.writeEF(true);
                   targetSegment.globalSteal.write(false);
                 }
+
+                // and sent back to the thief at once
+                if !localElts.isEmpty() {
+                  const buffer = localElts.toArray();
+                  stolenDom = {0..#buffer.size};
+                  stolenElts = buffer;
+                }
               }
             }
 
             if (stolenElts.size == 0) {
               // WS fail
+              lastGlobalVictim = -1;
               globalStealInProgress.write(false);
-              return (REMOVE_FAIL, default);
+              return failRemove(segment);
             }
             else {
               // insert the stolen elements
+              markBusy(segment);
+              segment.nGlobalSteals.add(1, memoryOrder.relaxed);
+              lastGlobalVictim = victimId;
               segment.addElements(stolenElts);
               globalStealInProgress.write(false);
               return (REMOVE_SUCCESS, segment.takeElement()[1]);
@@ -861,6 +1794,40 @@ module DistributedBag_DFS
     }
   } // end 'Bag' class
 
+  /*
+    Statistics of the pool of a locale, returned by :proc:`DistributedBagImpl.getLocalStats`.
+  */
+  record poolStats
+  {
+    var size: int;
+    var idleTasks: int;
+    var parkedTasks: int;
+    var localStealAttempts: int;
+    var localSteals: int;
+    var globalStealAttempts: int;
+    var globalSteals: int;
+  } // end 'poolStats' record
+
+  /*
+    Insertion handle on a given segment, returned by :proc:`DistributedBagImpl.sink`.
+    It exposes the same `pushBack` method as `list`, so that the search engines can
+    pass either of them to the problem's decomposition. Children are only written
+    at the tail: the split requests and the wake-ups of parked tasks are handled
+    once per decomposition, by the next removal of the owner (see 'Bag.remove').
+  */
+  record segmentSink
+  {
+    type eltType;
+
+    var bag: unmanaged Bag(eltType);
+    var taskId: int;
+
+    inline proc pushBack(elt: eltType): void
+    {
+      bag.segments[taskId].pushElement(elt);
+    }
+  } // end 'segmentSink' record
+
   /*
     A Segment is a parallel-safe pool, implemented as a non-blocking split deque
     (see header). In few words, it is a buffer of memory, called Block, along with
@@ -873,8 +1840,37 @@ module DistributedBag_DFS
 
     var globalSteal: atomic bool = false;
 
+    // whether the owner task is idle (see 'Bag.markIdle')
+    var idle: bool = false;
+    // number of failed removals in a row of the owner task (see 'Bag.idleWait')
+    var nFails: int = 0;
+    // number of elements removed by the owner task (see 'Bag.pushWork')
+    var nRemoves: int = 0;
+    // victim selection of the owner task (see 'Bag.victim'): last victim of a
+    // successful local steal, and state of the random generator
+    var lastVictim: int = -1;
+    var rngState: uint;
+
+    // steal statistics of the owner task, only updated with relaxed atomics
+    var nLocalStealAttempts: atomic int;
+    var nLocalSteals: atomic int;
+    var nGlobalStealAttempts: atomic int;
+    var nGlobalSteals: atomic int;
+    // whether the owner task is parked, and the signal used to wake it up
+    var parked: atomic bool = false;
+    var parkSignal: sync bool;
+
     var block: unmanaged Block(eltType);
 
+    // out-of-core tier (see 'spill'): file, number of elements and offset (in
+    // bytes) of each chunk, and size of the file
+    var spillPath: string;
+    var spillFile: file;
+    var spillChunks: list(int);
+    var spillOffsets: list(int);
+    var spillBytes: int;
+    var nSpilled: int;
+
     // private variables
     var o_split: int;
     /* var o_allstolen: bool; */
@@ -898,6 +1894,30 @@ module DistributedBag_DFS
       this.block = new unmanaged Block(eltType, distributedBagInitialSegmentCap);
     }
 
+    /*
+      Seed the random generator of the owner task, mixing the seed with the
+      identifier of the task (splitmix64 finalizer).
+    */
+    proc ref seedRandom(const seed: uint, const id: uint): void
+    {
+      var z = seed + (id + 1) * 0x9E3779B97F4A7C15;
+      z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+      z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+      z = z ^ (z >> 31);
+      rngState = if (z == 0) then 1 else z;
+    }
+
+    /*
+      Draw a random number (xorshift64*). Only called by the owner task.
+    */
+    inline proc ref nextRandom(): uint
+    {
+      rngState ^= rngState >> 12;
+      rngState ^= rngState << 25;
+      rngState ^= rngState >> 27;
+      return rngState * 0x2545F4914F6CDD1D;
+    }
+
     /*
       Return the size of the private portion.
     */
@@ -919,6 +1939,8 @@ module DistributedBag_DFS
     */
     inline proc isEmpty
     {
+      if distributedBagLockFree then return nElts == 0;
+
       lock_n.readFE();
       var n_shared = nElts_shared.read();
       var n_private = nElts_private;
@@ -931,19 +1953,7 @@ module DistributedBag_DFS
     */
     inline proc ref addElement(elt: eltType): bool
     {
-      // allocate a larger block with the double capacity.
-      if block.isFull {
-        if (block.cap == distributedBagMaxSegmentCap) then
-          return false;
-        lock_block.readFE();
-        block.cap = min(distributedBagMaxSegmentCap, 2*block.cap);
-        block.dom = {0..#block.cap};
-        lock_block.writeEF(true);
-      }
-
-      // add the element to the tail
-      block.pushTail(elt);
-      tail += 1;
+      pushElement(elt);
 
       // check split request
       if split_request.read() then split_release();
@@ -963,23 +1973,49 @@ module DistributedBag_DFS
       return true;
     }
 
+    /*
+      Add an element to the tail, without serving the split requests, which is left
+      to the next 'takeElement' of the owner (see 'segmentSink').
+    */
+    inline proc ref pushElement(elt: eltType): void
+    {
+      // allocate a larger block with the double capacity, or make room by
+      // spilling the oldest elements if the block has reached its maximum capacity.
+      if block.isFull {
+        if (block.cap >= distributedBagMaxSegmentCap) then spill();
+        else {
+          lock_block.readFE();
+          block.grow(min(distributedBagMaxSegmentCap, 2*block.cap));
+          lock_block.writeEF(true);
+        }
+      }
+
+      // add the element to the tail
+      block.pushTail(elt);
+      tail += 1;
+    }
+
     inline proc ref addElements(elts): int
     {
-      var size = elts.size;
+      const size = elts.size;
+
+      // if the elements do not fit in the largest block, add them one by one,
+      // which spills the oldest elements when needed.
+      if (block.size + size > distributedBagMaxSegmentCap) {
+        for elt in elts do addElement(elt);
+        return size;
+      }
 
       // allocate a larger block.
-      if (block.tailId + size > block.cap) {
-        const neededCap = block.cap*2**ceil(log2((block.tailId + size) / block.cap:real)):int;
-        if (neededCap >= distributedBagMaxSegmentCap) then
-          size = distributedBagMaxSegmentCap - block.tailId - 1;
+      if (block.size + size > block.cap) {
+        const neededCap = block.cap*2**ceil(log2((block.size + size) / block.cap:real)):int;
         lock_block.readFE();
-        block.cap = min(distributedBagMaxSegmentCap, neededCap);
-        block.dom = {0..#block.cap};
+        block.grow(min(distributedBagMaxSegmentCap, neededCap));
         lock_block.writeEF(true);
       }
 
       // add the elements to the tail
-      for elt in elts[0..#size] do block.pushTail(elt);
+      for elt in elts do block.pushTail(elt);
       tail += size;
 
       // check split request
@@ -990,13 +2026,193 @@ module DistributedBag_DFS
 
     // TODO: implement 'addElementsPtr'
 
+    /*
+      Make room in a block that has reached its maximum capacity, only executed by
+      the segment's owner. The oldest elements (at the head, i.e. the shallowest
+      ones) are written to the spill file as a new chunk, so that the block is at
+      most half full, and the head moves past them. Holding 'lock_block' excludes
+      the thieves.
+    */
+    proc ref spill(): void
+    {
+      lock_block.readFE();
+      lock.readFE();
+      const (h, s): (int, int) = (head.read(), split.read());
+      const n = tail - h;
+      const nSpill = max(0, n - block.cap / 2);
+
+      if (nSpill > 0) {
+        try! {
+          if !spillFile.isOpen() then
+            spillFile = open(spillPath, ioMode.cwr);
+
+          var writer = spillFile.writer(locking=false, region=spillBytes..);
+          writeSpilled(writer, h, nSpill);
+          spillOffsets.pushBack(spillBytes);
+          spillBytes = writer.offset();
+          writer.close();
+        }
+        spillChunks.pushBack(nSpill);
+        nSpilled += nSpill;
+      }
+
+      // the spilled elements are taken from the shared portion first
+      const newHead = h + nSpill;
+      const newSplit = max(s, newHead);
+
+      block.headId = newHead;
+      head.write(newHead);
+      split.write(newSplit);
+      lock.writeEF(true);
+
+      lock_n.readFE();
+      nElts_shared.write(newSplit - newHead);
+      lock_n.writeEF(true);
+
+      o_split = newSplit;
+      lock_block.writeEF(true);
+    }
+
+    /*
+      Read the most recently spilled chunk back, and insert it at the head, at the
+      logical positions its elements had before being spilled: they are shallower
+      than the elements in memory, so that they join the shared portion, and the
+      depth-first order is preserved. Only executed by the segment's owner. Nothing
+      is read back if the block cannot hold the chunk.
+    */
+    proc ref unspill(): void
+    {
+      const count = spillChunks[spillChunks.size - 1];
+      if (block.size + count > max(block.cap, distributedBagMaxSegmentCap)) then return;
+
+      spillChunks.popBack();
+      const offset = spillOffsets.popBack();
+      var buffer: [0..#count] eltType;
+
+      try! {
+        var reader = spillFile.reader(locking=false, region=offset..<spillBytes);
+        readSpilled(reader, buffer, 0, count);
+        reader.close();
+      }
+      spillBytes = offset;
+
+      lock_block.readFE();
+      if (block.size + count > block.cap) then
+        block.grow(min(distributedBagMaxSegmentCap, max(2*block.cap, block.size + count)));
+
+      // the head only moved forward since the chunk was spilled
+      lock.readFE();
+      const h = head.read() - count;
+      for i in 0..#count do block[h + i] = buffer[i];
+      block.headId = h;
+      head.write(h);
+      lock.writeEF(true);
+
+      lock_n.readFE();
+      nElts_shared.add(count);
+      lock_n.writeEF(true);
+
+      nSpilled -= count;
+      lock_block.writeEF(true);
+    }
+
+    /*
+      Read all the spilled elements, the oldest first, into the local array
+      `buffer` of `nSpilled` elements. The caller holds the block lock.
+    */
+    proc readSpill(ref buffer: [] eltType): void throws
+    {
+      if (nSpilled == 0) then return;
+
+      var reader = spillFile.reader(locking=false, region=0..<spillBytes);
+      readSpilled(reader, buffer, buffer.domain.low, nSpilled);
+      reader.close();
+    }
+
+    /*
+      Write the `n` elements of the block starting at logical position `from` into
+      `writer`: as raw bytes if they are plain-old-data, through their
+      `writeFields` method otherwise (e.g. `Node_QAP`, whose arrays live on the
+      heap). Other element types cannot be used with this bag.
+    */
+    proc writeSpilled(writer, const from: int, const n: int): void throws
+    {
+      if isPODType(eltType) then
+        block.writeElements(writer, from, n);
+      else if canResolveMethod(block[from], "writeFields", writer) then
+        for id in from..#n do block[id].writeFields(writer);
+      else
+        compilerError("DistributedBag_DFS: elements that are not plain-old-data must define 'writeFields' and 'readFields' to be spilled");
+    }
+
+    /*
+      Read `n` elements written by 'writeSpilled' from `reader` into `buffer`,
+      starting at index `start`.
+    */
+    proc readSpilled(reader, ref buffer: [] eltType, const start: int, const n: int): void throws
+    {
+      if isPODType(eltType) then
+        reader.readBinary(c_ptrTo(buffer[start]), n * c_sizeof(eltType):int);
+      else
+        for i in start..#n do buffer[i].readFields(reader);
+    }
+
+    /*
+      Copy the raw bytes of all the spilled elements into `writer`.
+    */
+    proc copySpill(writer): void throws
+    {
+      if (nSpilled == 0) then return;
+
+      const eltSize = c_sizeof(eltType):int;
+      var buffer: [0..#nSpilled] eltType;
+
+      readSpill(buffer);
+
+      writer.writeBinary(c_ptrTo(buffer[0]), nSpilled * eltSize);
+    }
+
+    /*
+      Snapshot of the elements of the segment, spilled ones first, taken with the
+      block lock held (see 'DistributedBagImpl.these').
+    */
+    proc ref snapshot(): [] eltType
+    {
+      lock_block.readFE();
+
+      const n = nElts;
+      var buffer: [0..#(nSpilled + n)] eltType;
+      try! readSpill(buffer);
+      for i in 0..#n do buffer[nSpilled + i] = block[block.headId + i];
+
+      lock_block.writeEF(true);
+
+      return buffer;
+    }
+
+    /*
+      Close and remove the spill file, if any.
+    */
+    proc ref closeSpill(): void
+    {
+      if !spillFile.isOpen() then return;
+
+      try! {
+        spillFile.close();
+        FileSystem.remove(spillPath);
+      }
+    }
+
     /*
       Remove an element.
     */
     inline proc ref takeElement(): (bool, eltType)
     {
-      // if the segment is empty...
-      if (nElts_private == 0) {
+      if distributedBagLockFree then return takeElementLockFree();
+
+      // if the private region is empty, take back part of the shared one, which
+      // the thieves may have left (see 'Bag.stealCount')
+      if ((nElts_private == 0) && !split_reacquire()) {
         var default: eltType;
         return (false, default);
       }
@@ -1007,18 +2223,6 @@ module DistributedBag_DFS
         return (true, elem);
       } */
 
-      // if the private region is empty...
-      if (nElts_private == 0) { //(o_split == tail) {
-        // if we successfully shring the shared region...
-        if split_reacquire() {
-          var elt = block.popTail();
-          tail -= 1; //?
-
-          return (true, elt);
-        }
-      }
-
-      // if the private region is not empty...
       var elt = block.popTail();
       tail -= 1;
 
@@ -1028,10 +2232,108 @@ module DistributedBag_DFS
       return (true, elt);
     }
 
-    // TODO: implement 'takeElements', needed by 'removeBulk'
+    /*
+      Take up to ``elts.size`` elements from the private region, the most recently
+      inserted first.
+    */
+    inline proc ref takeElements(ref elts: [] eltType): int
+    {
+      var n: int = 0;
+
+      while ((n < elts.size) && (nElts_private > 0)) {
+        const (hasElt, elt) = takeElement();
+        if !hasElt then break;
+        elts[elts.domain.low + n] = elt;
+        n += 1;
+      }
+
+      return n;
+    }
 
     // TODO: implement 'transferElements'
 
+    /*
+      Lock-free removal (see :const:`distributedBagLockFree`). Thieves never reach
+      the private portion, which the owner pops without synchronization. When it is
+      empty, the owner takes back the newest half of the shared portion by moving
+      the split, then reads the head: a thief that read the split before it moved
+      can still claim at most one element, the head. Only in that case does the
+      owner resolve the contention, under the block lock.
+    */
+    inline proc ref takeElementLockFree(): (bool, eltType)
+    {
+      var default: eltType;
+
+      if (tail > o_split) {
+        const elt = block.popTail();
+        tail -= 1;
+
+        // check split request
+        if split_request.read() then split_release();
+
+        return (true, elt);
+      }
+
+      const h = head.read();
+      if (h >= tail) then return (false, default);
+
+      const s = (h + tail) / 2;
+      split.write(s);
+
+      if (head.read() < s) {
+        nElts_shared.sub(tail - s);
+        o_split = s;
+
+        const elt = block.popTail();
+        tail -= 1;
+        return (true, elt);
+      }
+
+      // the head is contended: no thief can move it while we hold the block lock
+      lock_block.readFE();
+      const h2 = head.read();
+      if (h2 >= tail) {
+        lock_block.writeEF(true);
+        return (false, default);
+      }
+
+      // the elements past the head become private, and we take the head itself
+      head.write(h2 + 1);
+      const elt = block.popHead();
+      lock_block.writeEF(true);
+
+      nElts_shared.sub(tail - h2);
+      o_split = h2 + 1;
+
+      return (true, elt);
+    }
+
+    /*
+      Steal of the lock-free variant (see :const:`distributedBagLockFree`): the head
+      is read before the split, and claimed with a compare-and-swap against the
+      owner. The caller holds the block lock, which excludes the other thieves.
+    */
+    inline proc ref stealElementLockFree(): (bool, eltType)
+    {
+      var default: eltType;
+
+      const h = head.read();
+      if (h >= split.read()) {
+        // set the split request, if not already set
+        if !split_request.read() then split_request.write(true);
+        return (false, default);
+      }
+
+      const elt = block[h];
+      if head.compareAndSwap(h, h + 1) {
+        block.headId = h + 1;
+        nElts_shared.sub(1);
+        return (true, elt);
+      }
+
+      return (false, default);
+    }
+
     /*
       Perform simultaneously two compareAndSwap operations. This ensures that
       both atomic variables are accessed at the same time.
@@ -1061,6 +2363,8 @@ module DistributedBag_DFS
     */
     inline proc ref stealElement(): (bool, eltType)
     {
+      if distributedBagLockFree then return stealElementLockFree();
+
       var default: eltType;
 
       // if the shared region becomes empty due to a concurrent operation
@@ -1096,6 +2400,49 @@ module DistributedBag_DFS
       return (false, default);
     }
 
+    /*
+      Steal up to ``elts.size`` elements from the head of the shared portion, in a
+      single move of the head, and store them in ``elts``, the oldest first. Return
+      the number of stolen elements.
+    */
+    inline proc ref stealElements(ref elts: [] eltType): int
+    {
+      if (distributedBagLockFree || (elts.size == 1)) {
+        const (hasElt, elt) = stealElement();
+        if hasElt then elts[elts.domain.low] = elt;
+        return hasElt:int;
+      }
+
+      // if the shared region becomes empty due to a concurrent operation
+      if (nElts_shared.read() == 0) then return 0;
+
+      lock.readFE(); // set locked (empty)
+      var (h, s): (int, int) = (head.read(), split.read());
+      lock.writeEF(true); // set unlocked (full)
+
+      // check eligibility, again
+      const n = min(elts.size, s - h);
+      if (n > 0) {
+        // try to move the pointers
+        if simCAS(head, split, h, s, h+n, s) {
+          lock_n.readFE();
+          for i in 0..#n do elts[elts.domain.low + i] = block.popHead();
+          nElts_shared.sub(n);
+          lock_n.writeEF(true);
+
+          return n;
+        }
+        else {
+          return 0;
+        }
+      }
+
+      // set the split request, if not already set
+      if !split_request.read() then split_request.write(true);
+
+      return 0;
+    }
+
     /*
       Increase the shared portion of the segment (and decrease the private one).
     */
@@ -1104,6 +2451,16 @@ module DistributedBag_DFS
       // fast exit
       if (nElts_private <= 1) then return;
 
+      if distributedBagLockFree {
+        // the shared counter is increased first, so that it never goes below zero
+        const new_split: int = ((o_split + tail + 1) / 2): int;
+        nElts_shared.add(new_split - o_split);
+        split.write(new_split);
+        o_split = new_split;
+        split_request.write(false);
+        return;
+      }
+
       // compute the new split position
       var new_split: int = ((o_split + tail + 1) / 2): int;
       lock.readFE(); // block until its full and set locked (empty)
@@ -1122,93 +2479,188 @@ module DistributedBag_DFS
     }
 
     /*
-      Decrease the shared portion of the segment (and increase the private one).
+      Decrease the shared portion of the segment (and increase the private one):
+      the newest half of the shared elements, at least one, move to the private
+      portion. Only executed by the segment's owner; holding 'lock_block' excludes
+      the thieves. Return false if the shared portion is empty.
     */
     inline proc ref split_reacquire(): bool
     {
       // fast exit
-      if (nElts_shared.read() <= 1) then return false;
+      if (nElts_shared.read() == 0) then return false;
 
+      lock_block.readFE();
       lock.readFE(); // block until its full and set locked (empty)
-      var (h, s): (int, int) = (head.read(), split.read()); // o_split ?
+      const (h, s): (int, int) = (head.read(), split.read());
+      const new_split: int = (h + s) / 2;
+      if (new_split < s) then split.write(new_split);
       lock.writeEF(true); // set unlocked (full)
-      if (h != s) {
-        var new_split: int = ((h + s) / 2): int;
-        lock.readFE(); // block until its full and set locked (empty)
-        split.write(new_split);
-        lock.writeEF(true); // set unlocked (full)
+
+      if (new_split < s) {
         lock_n.readFE();
-        nElts_shared.sub(new_split - o_split);
+        nElts_shared.sub(s - new_split);
         lock_n.writeEF(true);
         o_split = new_split;
-        // fence
-        atomicFence();
-        h = head.read();
-        if (h != s) {
-          if (h > new_split) {
-            new_split = ((h + s) / 2): int;
-            lock.readFE(); // block until its full and set locked (empty)
-            split.write(new_split);
-            lock.writeEF(true); // set unlocked (full)
-            lock_n.readFE();
-            nElts_shared.sub(new_split - o_split);
-            lock_n.writeEF(true);
-            o_split = new_split;
-          }
-          return false;
-        }
       }
-      /* allstolen.write(true);
-      o_allstolen = true; */
-      return true;
+      lock_block.writeEF(true);
+
+      return (new_split < s);
     }
   } // end 'Segment' record
 
   /*
-    A Block is a Chapel array that holds a buffer of memory. Each block size
-    *should* be a power of two, as we extend the size of each full block by
-    twice the size. It should be noted that the block itself is not parallel-safe,
-    and access must be synchronized.
+    A Block is a ring buffer made of fixed-size chunks. Elements are identified by
+    their logical position, which only increases at both ends (`headId`, `tailId`)
+    and is mapped to a chunk and an offset modulo the capacity, so that the room
+    left by the elements removed at the head is reused. When full, the block grows
+    by adding chunks: only the references to the chunks are moved, and at most one
+    chunk of elements is copied, when the head and the tail share a chunk. It
+    should be noted that the block itself is not parallel-safe, and access must be
+    synchronized.
   */
   @chpldoc.nodoc
   class Block
   {
     type eltType;
-    var dom: domain(1);
-    var elts: [dom] eltType;
+    var chunkSize: int; // number of elements of a chunk
+    var chunksDom: domain(1);
+    var chunks: [chunksDom] unmanaged Chunk(eltType)?;
     var cap: int;    // capacity of the block
-    var headId: int; // index of the head element
-    var tailId: int; // index of the tail element
+    var headId: int; // logical position of the head element
+    var tailId: int; // logical position following the tail element
+
+    inline proc size
+    {
+      return tailId - headId;
+    }
 
     inline proc isFull
     {
-      return tailId == cap;
+      return size == cap;
     }
 
     proc init(type eltType, capacity)
     {
       this.eltType = eltType;
-      this.dom = {0..#capacity};
+      this.chunkSize = capacity;
+      this.chunksDom = {0..0};
       this.cap = capacity;
     }
 
+    proc postinit()
+    {
+      chunks[0] = new unmanaged Chunk(eltType, chunkSize);
+    }
+
+    proc deinit()
+    {
+      for chunk in chunks do delete chunk;
+    }
+
+    /*
+      Access the element at logical position `id`.
+    */
+    inline proc this(const id: int) ref
+    {
+      return chunks[(id / chunkSize) % chunksDom.size]!.elts[id % chunkSize];
+    }
+
     inline proc pushTail(elt: eltType): void
     {
-      elts[tailId] = elt;
+      this[tailId] = elt;
       tailId += 1;
     }
 
     inline proc popTail(): eltType
     {
       tailId -= 1;
-      return elts[tailId];
+      return this[tailId];
     }
 
     inline proc popHead(): eltType
     {
-      var elt = elts[headId];
+      var elt = this[headId];
       headId += 1;
       return elt;
     }
+
+    /*
+      Increase the capacity to at least `newCap` (rounded up to a whole number of
+      chunks), keeping the logical positions.
+    */
+    proc grow(const newCap: int): void
+    {
+      const oldSlots = chunksDom.size;
+      const newSlots = max(oldSlots + 1, (newCap + chunkSize - 1) / chunkSize);
+      var newChunks: [0..#newSlots] unmanaged Chunk(eltType)?;
+      var used: [0..#oldSlots] bool;
+
+      if (size > 0) {
+        const (first, last) = (headId / chunkSize, (tailId - 1) / chunkSize);
+
+        // the chunks holding elements keep their logical number
+        for c in first..min(last, first + oldSlots - 1) {
+          newChunks[c % newSlots] = chunks[c % oldSlots];
+          used[c % oldSlots] = true;
+        }
+
+        // if the head and the tail share a chunk, the tail elements get their own
+        if (last - first == oldSlots) {
+          const tailChunk = new unmanaged Chunk(eltType, chunkSize);
+          const shared = chunks[last % oldSlots]!;
+          for i in 0..(tailId - 1) % chunkSize do tailChunk.elts[i] = shared.elts[i];
+          newChunks[last % newSlots] = tailChunk;
+        }
+      }
+
+      // the empty chunks are reused, and new ones fill the remaining slots
+      var slot = 0;
+      for i in 0..#oldSlots {
+        if used[i] then continue;
+        while (newChunks[slot] != nil) do slot += 1;
+        newChunks[slot] = chunks[i];
+      }
+      for chunk in newChunks {
+        if (chunk == nil) then chunk = new unmanaged Chunk(eltType, chunkSize);
+      }
+
+      chunksDom = {0..#newSlots};
+      chunks = newChunks;
+      cap = newSlots * chunkSize;
+    }
+
+    /*
+      Write the raw bytes of the `n` elements starting at logical position `from`
+      into `writer`, one contiguous part per chunk.
+    */
+    proc writeElements(writer, const from: int, const n: int): void throws
+    {
+      const eltSize = c_sizeof(eltType):int;
+      var id = from;
+
+      while (id < from + n) {
+        const offset = id % chunkSize;
+        const k = min(from + n - id, chunkSize - offset);
+        writer.writeBinary(c_ptrTo(this[id]), k * eltSize);
+        id += k;
+      }
+    }
   } // end 'Block' class
+
+  /*
+    Fixed-size storage of a Block.
+  */
+  @chpldoc.nodoc
+  class Chunk
+  {
+    type eltType;
+    var dom: domain(1);
+    var elts: [dom] eltType;
+
+    proc init(type eltType, size: int)
+    {
+      this.eltType = eltType;
+      this.dom = {0..#size};
+    }
+  } // end 'Chunk' class
 } // end module
@@ -0,0 +1,177 @@
+module Incumbent
+{
+  use PrivateDist;
+  use Time;
+
+  /*
+    Number of decompositions performed by a task between two refreshes of its
+    local copy of the incumbent.
+  */
+  config const incumbentPollRate: int = 64;
+
+  /*
+    Best solution found so far, shared by all the tasks of a search. Improvements
+    are published through a compare-and-swap loop and reads are relaxed, so that
+    tasks can poll the value without taking any lock.
+
+    In distributed mode, each locale holds its own replica (see
+    :proc:`newReplicatedIncumbent`), and improvements are asynchronously pushed
+    to the other replicas.
+  */
+  class Incumbent
+  {
+    const minimize: bool;
+    var best: atomic int;
+
+    // replicas of the other locales, if any
+    var replicaDom: domain(1);
+    var replicas: [replicaDom] unmanaged Incumbent?;
+
+    // number of broadcasts sent by this replica and not yet received
+    var pending: atomic int;
+
+    // time of the last improvement of this replica, in seconds since the epoch
+    var lastImprovement: atomic real;
+
+    proc init(const initBound: int, const minimize: bool = true)
+    {
+      this.minimize = minimize;
+      init this;
+      this.best.write(initBound);
+      this.lastImprovement.write(timeSinceEpoch().totalSeconds());
+    }
+
+    proc deinit()
+    {
+      pending.waitFor(0);
+    }
+
+    /*
+      Return `true` if `a` is strictly better than `b`, regarding the direction
+      of the optimization.
+    */
+    inline proc isBetter(const a: int, const b: int): bool
+    {
+      return if minimize then (a < b) else (a > b);
+    }
+
+    /*
+      Relaxed read of the incumbent.
+    */
+    inline proc read(): int
+    {
+      return best.read(memoryOrder.relaxed);
+    }
+
+    /*
+      Replace the incumbent by `val` if the latter is strictly better. Return `true`
+      if the incumbent changed.
+    */
+    proc merge(const val: int): bool
+    {
+      var cur = best.read();
+
+      while isBetter(val, cur) {
+        if best.compareAndSwap(cur, val) {
+          lastImprovement.write(timeSinceEpoch().totalSeconds(), memoryOrder.relaxed);
+          return true;
+        }
+        cur = best.read();
+      }
+
+      return false;
+    }
+
+    /*
+      Try to replace the incumbent by `val`, and forward it to the other replicas
+      on success. Return `false` if another task already published a strictly
+      better value, `true` otherwise.
+    */
+    proc update(const val: int): bool
+    {
+      if merge(val) {
+        if (replicaDom.size > 0) then broadcast(val);
+        return true;
+      }
+
+      return (val == read());
+    }
+
+    /*
+      Fire-and-forget propagation of an improvement to the replicas of the other
+      locales.
+    */
+    proc broadcast(const val: int): void
+    {
+      for r in replicas {
+        const replica = r!;
+        if (replica.locale == here) then continue;
+
+        pending.add(1);
+        begin on replica {
+          replica.merge(val);
+          pending.sub(1);
+        }
+      }
+    }
+
+    /*
+      Refresh the task-local copy of the incumbent `best_task`, if another task
+      published a better value. This is cheap enough to be called from within
+      `decompose`, right before bounding the children of a node.
+    */
+    inline proc refresh(ref best_task: int): void
+    {
+      const cur = read();
+      if isBetter(cur, best_task) then best_task = cur;
+    }
+  } // end class
+
+  /*
+    Allocate one replica of the incumbent on each locale. The tasks of a locale
+    only read and update their local replica.
+  */
+  proc newReplicatedIncumbent(const initBound: int, const minimize: bool)
+  {
+    var replicas: [PrivateSpace] unmanaged Incumbent?;
+
+    coforall loc in Locales with (ref replicas) do on loc {
+      replicas[here.id] = new unmanaged Incumbent(initBound, minimize);
+    }
+
+    coforall loc in Locales do on loc {
+      const replica = replicas[here.id]!;
+      replica.replicaDom = {0..#numLocales};
+      replica.replicas = replicas;
+    }
+
+    return replicas;
+  }
+
+  /*
+    Wait for all the in-flight broadcasts, after which all the replicas hold the
+    same value, and return that value.
+  */
+  proc settleIncumbent(const ref replicas: [] unmanaged Incumbent?): int
+  {
+    coforall loc in Locales do on loc {
+      replicas[here.id]!.pending.waitFor(0);
+    }
+
+    return replicas[0]!.read();
+  }
+
+  /*
+    Free the replicas allocated by :proc:`newReplicatedIncumbent`.
+  */
+  proc deleteReplicatedIncumbent(ref replicas: [] unmanaged Incumbent?): void
+  {
+    settleIncumbent(replicas);
+
+    coforall loc in Locales with (ref replicas) do on loc {
+      delete replicas[here.id];
+      replicas[here.id] = nil;
+    }
+  }
+
+} // end module
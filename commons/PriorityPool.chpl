@@ -0,0 +1,481 @@
+/*
+  A parallel multi-pool for best-first and hybrid tree-search, intended for
+  single-locale executions.
+
+  Each task owns a pool made of a binary heap, ordered by the bound of the nodes,
+  and a stack. The heap serves the best-first part of the search and the stack
+  the depth-first part:
+
+      * "best":   children are pushed into the heap. Once the heap of a task holds
+                  :const:`priorityPoolMemCap` nodes, further children go to the stack,
+                  which is emptied first. The search thus falls back to DFS until
+                  the heap shrinks again.
+
+      * "hybrid": children are pushed into the stack, i.e. the search is a DFS, but
+                  every :const:`priorityPoolHybridPeriod` removals the stack is
+                  moved into the heap, so that the search restarts from the most
+                  promising node. Moves stop once the heap reaches the memory cap.
+
+  When its pool is empty, a task steals from the pool whose best node has the
+  best bound, taking that node. Termination is detected as in
+  :mod:`DistributedBag_DFS`, which this pool mimics the interface of (`add`,
+  `addBulk`, `sink` and `remove`).
+*/
+module PriorityPool
+{
+  use List;
+  use DistributedBag_DFS only poolStats;
+
+  /*
+    Outputs of the remove operation, identical to those of distBag_DFS.
+  */
+  private param REMOVE_SUCCESS    =  1;
+  private param REMOVE_FAIL       = -1;
+  private param REMOVE_TERMINATED = -2;
+
+  /*
+    The maximum number of nodes in the heap of each task.
+  */
+  config const priorityPoolMemCap: int = 1024 * 1024;
+  /*
+    The number of removals between two best-first restarts in "hybrid" mode.
+  */
+  config const priorityPoolHybridPeriod: int = 1024;
+
+  class PriorityPool
+  {
+    type eltType;
+    type problemType;
+
+    const numTasks: int;
+    const problem: problemType; // provides the bound of the nodes
+    const minimize: bool;
+    const hybrid: bool;
+
+    var pools: [0..#numTasks] TaskPool(eltType);
+
+    // Termination detection (see 'DistributedBag_DFS.Bag.isPassive')
+    var nIdleTasks: atomic int;
+    var activations: atomic int;
+    var terminated: atomic bool = false;
+
+    proc init(type eltType, problem, const hybrid: bool,
+      const numTasks: int = here.maxTaskPar)
+    {
+      this.eltType = eltType;
+      this.problemType = problem.borrow().type;
+      this.numTasks = numTasks;
+      this.problem = problem.borrow();
+      this.minimize = problem.isMinimization();
+      this.hybrid = hybrid;
+    }
+
+    /*
+      Priority of a node: the lower, the more promising (see `Problem.getBound`).
+    */
+    inline proc key(const elt: eltType): int
+    {
+      const bound = problem.getBound(elt);
+      return if minimize then bound else -bound;
+    }
+
+    /*
+      Insert an element in the calling task's pool.
+    */
+    proc add(elt: eltType, const taskId: int): bool
+    {
+      ref pool = pools[taskId];
+
+      pool.lock.readFE();
+      if (!hybrid && (pool.heap.size < priorityPoolMemCap)) then
+        pool.heap.push(key(elt), elt);
+      else
+        pool.stack.pushBack(elt);
+      pool.updateTopKey();
+      pool.lock.writeEF(true);
+
+      return true;
+    }
+
+    /*
+      Insert elements in bulk in the calling task's pool.
+    */
+    proc addBulk(elts, const taskId: int): int
+    {
+      for elt in elts do add(elt, taskId);
+
+      return elts.size;
+    }
+
+    /*
+      Obtain a handle on the calling task's pool, to be passed to the problem's
+      decomposition.
+    */
+    proc sink(const taskId: int)
+    {
+      return new poolSink(eltType, this, taskId);
+    }
+
+    /*
+      Remove an element from the calling task's pool, or steal one from the most
+      promising pool. Return the same codes as `distBag_DFS.remove`.
+    */
+    proc remove(const taskId: int): (int, eltType)
+    {
+      ref pool = pools[taskId];
+      var default: eltType;
+
+      // the search may have been stopped (see 'stop')
+      if terminated.read(memoryOrder.relaxed) then return (REMOVE_TERMINATED, default);
+
+      pool.lock.readFE();
+      if hybrid {
+        pool.nRemoves += 1;
+        if ((pool.nRemoves % priorityPoolHybridPeriod == 0) &&
+            (pool.heap.size + pool.stack.size <= priorityPoolMemCap)) {
+          for elt in pool.stack do pool.heap.push(key(elt), elt);
+          pool.stack.clear();
+        }
+      }
+      if !pool.stack.isEmpty() {
+        const elt = pool.stack.popBack();
+        pool.updateTopKey();
+        pool.lock.writeEF(true);
+        return (REMOVE_SUCCESS, elt);
+      }
+      else if (pool.heap.size > 0) {
+        const elt = pool.heap.pop();
+        pool.updateTopKey();
+        pool.lock.writeEF(true);
+        return (REMOVE_SUCCESS, elt);
+      }
+      pool.lock.writeEF(true);
+
+      if terminated.read() then return (REMOVE_TERMINATED, default);
+
+      // selection of the victim whose best node is the most promising
+      var victimId = -1;
+      var victimKey = max(int);
+      for i in 0..#numTasks {
+        const k = pools[i].topKey.read();
+        if ((i != taskId) && (k < victimKey)) {
+          victimId = i;
+          victimKey = k;
+        }
+      }
+
+      pool.nStealAttempts.add(1, memoryOrder.relaxed);
+
+      if (victimId != -1) {
+        ref victim = pools[victimId];
+
+        victim.lock.readFE();
+        var hasElt = true;
+        var elt: eltType;
+        if (victim.heap.size > 0) then elt = victim.heap.pop();
+        else if !victim.stack.isEmpty() then elt = victim.stack.popFront();
+        else hasElt = false;
+
+        if hasElt {
+          markBusy(pool);
+          pool.nSteals.add(1, memoryOrder.relaxed);
+          victim.updateTopKey();
+          victim.lock.writeEF(true);
+          return (REMOVE_SUCCESS, elt);
+        }
+        victim.lock.writeEF(true);
+      }
+
+      // failure: check termination
+      markIdle(pool);
+      if isPassive() then terminated.write(true);
+      if terminated.read() then return (REMOVE_TERMINATED, default);
+
+      currentTask.yieldExecution();
+
+      return (REMOVE_FAIL, default);
+    }
+
+    /*
+      Not supported: elements are removed one at a time, so that the order of the
+      search is preserved. Always return 0 (see `DistributedBagImpl.removeBulk`).
+    */
+    proc removeBulk(const taskId: int, ref elts: [] eltType): int
+    {
+      return 0;
+    }
+
+    /*
+      Stop all the tasks: subsequent removals report the termination, even though
+      elements remain in the pools.
+    */
+    proc stop(): void
+    {
+      terminated.write(true);
+    }
+
+    /*
+      Check if termination has been detected, or the pools stopped (see `stop`).
+    */
+    proc isTerminated(): bool
+    {
+      return terminated.read();
+    }
+
+    /*
+      Not used: the pools are ordered by bound (see `DistributedBagImpl.setMaxDepth`).
+    */
+    proc setMaxDepth(const maxDepth: int): void
+    {}
+
+    /*
+      Iterate over the elements of the pools. Not parallel-safe, intended to be
+      used once the tasks are done.
+    */
+    iter these(): eltType
+    {
+      for i in 0..#numTasks {
+        for j in 0..#pools[i].heap.size do yield pools[i].heap.elts[j];
+        for elt in pools[i].stack do yield elt;
+      }
+    }
+
+    @chpldoc.nodoc
+    inline proc markIdle(ref pool: TaskPool(eltType)): void
+    {
+      if !pool.idle {
+        pool.idle = true;
+        nIdleTasks.add(1);
+      }
+    }
+
+    @chpldoc.nodoc
+    inline proc markBusy(ref pool: TaskPool(eltType)): void
+    {
+      if pool.idle {
+        pool.idle = false;
+        activations.add(1);
+        nIdleTasks.sub(1);
+      }
+    }
+
+    /*
+      Obtain statistics on the pools, for monitoring purposes. No lock is taken,
+      so that the values are approximate under concurrent operations.
+    */
+    proc getLocalStats(): poolStats
+    {
+      var stats: poolStats;
+
+      for i in 0..#numTasks {
+        ref pool = pools[i];
+
+        stats.size += pool.heap.size + pool.stack.size;
+        stats.localStealAttempts += pool.nStealAttempts.read(memoryOrder.relaxed);
+        stats.localSteals += pool.nSteals.read(memoryOrder.relaxed);
+      }
+      stats.idleTasks = nIdleTasks.read(memoryOrder.relaxed);
+
+      return stats;
+    }
+
+    /*
+      Check if all the tasks are idle and all the pools are empty.
+    */
+    proc isPassive(): bool
+    {
+      const act = activations.read();
+
+      if (nIdleTasks.read() != numTasks) then return false;
+
+      for i in 0..#numTasks {
+        ref pool = pools[i];
+
+        pool.lock.readFE();
+        const n = pool.heap.size + pool.stack.size;
+        pool.lock.writeEF(true);
+
+        if (n > 0) then return false;
+      }
+
+      return ((nIdleTasks.read() == numTasks) && (activations.read() == act));
+    }
+  } // end 'PriorityPool' class
+
+  /*
+    Insertion handle on a given task's pool, returned by :proc:`PriorityPool.sink`.
+  */
+  record poolSink
+  {
+    type eltType;
+
+    var pool; // the PriorityPool
+    var taskId: int;
+
+    inline proc pushBack(elt: eltType): void
+    {
+      pool.add(elt, taskId);
+    }
+  } // end 'poolSink' record
+
+  /*
+    The pool of a task: a heap and a stack, protected by a lock.
+  */
+  @chpldoc.nodoc
+  record TaskPool
+  {
+    type eltType;
+
+    var heap: Heap(eltType);
+    var stack: Deque(eltType);
+
+    // best key of the pool, read by the thieves without locking
+    var topKey: atomic int = max(int);
+
+    // private variables of the owner task
+    var idle: bool = false;
+    var nRemoves: int;
+
+    // steal statistics of the owner task
+    var nStealAttempts: atomic int;
+    var nSteals: atomic int;
+
+    // lock (initially unlocked)
+    var lock: sync bool = true;
+
+    proc init(type eltType)
+    {
+      this.eltType = eltType;
+      this.heap = new Heap(eltType);
+      this.stack = new Deque(eltType);
+    }
+
+    /*
+      Update 'topKey', with the lock held. Elements of the stack are not ordered,
+      so only the heap is considered, unless it is empty.
+    */
+    inline proc ref updateTopKey(): void
+    {
+      if (heap.size > 0) then topKey.write(heap.keys[0]);
+      else if !stack.isEmpty() then topKey.write(max(int) - 1);
+      else topKey.write(max(int));
+    }
+  } // end 'TaskPool' record
+
+  /*
+    A binary min-heap of elements associated with integer keys. Its capacity is
+    doubled when full.
+  */
+  @chpldoc.nodoc
+  record Heap
+  {
+    type eltType;
+    var dom: domain(1) = {0..#1024};
+    var keys: [dom] int;
+    var elts: [dom] eltType;
+    var size: int;
+
+    proc ref push(const key: int, const elt: eltType): void
+    {
+      if (size == dom.size) then dom = {0..#(2*dom.size)};
+
+      // sift up
+      var i = size;
+      while (i > 0) {
+        const p = (i - 1) / 2;
+        if (keys[p] <= key) then break;
+        keys[i] = keys[p];
+        elts[i] = elts[p];
+        i = p;
+      }
+      keys[i] = key;
+      elts[i] = elt;
+      size += 1;
+    }
+
+    proc ref pop(): eltType
+    {
+      const top = elts[0];
+      size -= 1;
+
+      if (size > 0) {
+        const key = keys[size];
+        const elt = elts[size];
+
+        // sift down
+        var i = 0;
+        while true {
+          var c = 2*i + 1;
+          if (c >= size) then break;
+          if ((c + 1 < size) && (keys[c+1] < keys[c])) then c += 1;
+          if (key <= keys[c]) then break;
+          keys[i] = keys[c];
+          elts[i] = elts[c];
+          i = c;
+        }
+        keys[i] = key;
+        elts[i] = elt;
+      }
+
+      return top;
+    }
+  } // end 'Heap' record
+
+  /*
+    A double-ended queue of elements, stored in a ring buffer: the owner uses it as
+    a stack, and the thieves take its oldest element in constant time. Its capacity
+    is doubled when full.
+  */
+  @chpldoc.nodoc
+  record Deque
+  {
+    type eltType;
+    var dom: domain(1) = {0..#1024};
+    var elts: [dom] eltType;
+    var head: int; // index of the oldest element
+    var size: int;
+
+    inline proc isEmpty(): bool
+    {
+      return size == 0;
+    }
+
+    proc ref pushBack(const elt: eltType): void
+    {
+      if (size == dom.size) {
+        // unwrap the elements into the larger buffer
+        const n = dom.size;
+        dom = {0..#(2*n)};
+        for i in 0..#head do elts[n + i] = elts[i];
+      }
+
+      elts[(head + size) % dom.size] = elt;
+      size += 1;
+    }
+
+    proc ref popBack(): eltType
+    {
+      size -= 1;
+      return elts[(head + size) % dom.size];
+    }
+
+    proc ref popFront(): eltType
+    {
+      const elt = elts[head];
+      head = (head + 1) % dom.size;
+      size -= 1;
+      return elt;
+    }
+
+    proc ref clear(): void
+    {
+      head = 0;
+      size = 0;
+    }
+
+    iter these(): eltType
+    {
+      for i in 0..#size do yield elts[(head + i) % dom.size];
+    }
+  } // end 'Deque' record
+} // end module
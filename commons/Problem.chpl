@@ -1,5 +1,8 @@
 module Problem
 {
+  use Incumbent;
+  private use Reflection;
+
   class Problem
   {
     proc copy()
@@ -7,17 +10,111 @@ module Problem
       compilerError("Problem.copy() not implemented");
     }
 
-    proc decompose(type Node, const parent: Node, ref tree_loc: int, ref num_sol: int,
-      ref max_depth: int, ref best: int, lock: sync bool, ref best_task: int)
+    /*
+      Generate the children of `parent` that survive the bounding step. Each of
+      them is passed to `children.pushBack()`, where `children` is the pool of the
+      calling task (or any sink exposing `pushBack`), so that no intermediate
+      container is needed. Nodes expose their bound through `bound`, which the
+      best-first and hybrid search strategies use as priority.
+    */
+    proc decompose(type Node, const parent: Node, ref children, ref tree_loc: int,
+      ref num_sol: int, ref max_depth: int, ref best_task: int, incumbent: borrowed Incumbent)
     {
       compilerError("Problem.decompose() not implemented");
     }
 
+    /*
+      Decompose the `nParents` first elements of `parents` at once. The default
+      implementation decomposes them one by one; problems override it to amortize
+      the per-call overhead, e.g. by bounding all the children in a single kernel.
+    */
+    proc decomposeBatch(type Node, const parents: [] Node, const nParents: int, ref children,
+      ref tree_loc: int, ref num_sol: int, ref max_depth: int, ref best_task: int,
+      incumbent: borrowed Incumbent)
+    {
+      for i in 0..#nParents do
+        decompose(Node, parents[i], children, tree_loc, num_sol, max_depth, best_task, incumbent);
+    }
+
     proc getInitBound(): int
     {
       compilerError("Problem.getInitBound() not implemented");
     }
 
+    /*
+      Depth of the leaves of the search tree, used by the pools to estimate the
+      remaining work below a node. 0 if unknown, e.g. for irregular trees.
+    */
+    proc getMaxDepth(): int
+    {
+      return 0;
+    }
+
+    /*
+      Whether the subtree rooted at `node` is small enough to be explored in place
+      by the task that removed it (see `util.cutoffDepth`), i.e. whether `node` lies
+      within `cutoff` levels of the leaves. Problems whose nodes have no `depth`, or
+      whose tree depth is unknown, never cut off unless they override it.
+    */
+    proc isSmallSubtree(const node, const cutoff: int): bool
+    {
+      if hasField(node.type, "depth") {
+        const maxDepth = getMaxDepth();
+        if ((cutoff > 0) && (maxDepth > 0)) then return (maxDepth - node.depth: int <= cutoff);
+      }
+
+      return false;
+    }
+
+    /*
+      Whether `node` is dominated by the best solution found so far, `best`, and
+      can be discarded without being decomposed. Nodes are pruned against the
+      incumbent when they are created; this check catches the ones that became
+      dominated while waiting in a pool. Ties are kept, as in the decompositions,
+      so that all the optimal solutions are counted.
+    */
+    inline proc isPruned(const node, const best: int): bool
+    {
+      const bound = getBound(node);
+      return if isMinimization() then (bound > best) else (bound < best);
+    }
+
+    /*
+      Bound of `node`, the only way the engines, the pools and the gap report read
+      it. By default, the `bound` field of the node; problems whose nodes store it
+      under another name, or have none, override it.
+    */
+    proc getBound(const node): int
+    {
+      return node.bound;
+    }
+
+    /*
+      Problem-defined priority of a child (see `util.childOrder`): the lower, the
+      earlier it is explored. By default, its bound, best first.
+    */
+    proc childKey(const node): int
+    {
+      return if isMinimization() then getBound(node) else -getBound(node);
+    }
+
+    /*
+      Primal heuristic run concurrently with the search by a dedicated task of
+      locale 0 (see `util.heuristicTask`): it publishes the solutions it finds to
+      `incumbent`, until `done` is set. Does nothing by default.
+    */
+    proc improveIncumbent(incumbent: borrowed Incumbent, const ref done: atomic bool): void
+    {}
+
+    /*
+      Direction of the optimization, used to compare candidate solutions against
+      the incumbent. Maximization problems must override it.
+    */
+    proc isMinimization(): bool
+    {
+      return true;
+    }
+
     // =======================
     // Utility functions
     // =======================
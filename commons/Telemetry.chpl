@@ -0,0 +1,65 @@
+module Telemetry
+{
+  use IO;
+  use Time;
+
+  /*
+    Interval between two progress reports, in seconds (0 disables the reports).
+  */
+  config const telemetryInterval: real = 0.0;
+  /*
+    Prefix of the files the reports are appended to, one per locale. If empty,
+    the reports are printed on the standard output.
+  */
+  config const telemetryFile: string = "";
+
+  /*
+    Periodically report the progress of the tasks of this locale, until `done` is
+    set: explored nodes (from the per-task counters `exploredTree`), pool size, idle
+    and parked tasks, steal attempts and successes, and incumbent. It only reads
+    counters, racily or through relaxed atomics, and never takes a lock, so that
+    the reported values are approximate.
+  */
+  proc telemetry(const ref pool, const ref exploredTree: [] int, incumbent,
+    const ref done: atomic bool): void
+  {
+    const path = telemetryFile + "_" + here.id:string + ".log";
+    var timer: stopwatch;
+    var lastReport, lastTree: int;
+
+    timer.start();
+
+    while !done.read() {
+      sleep(min(telemetryInterval, 0.1));
+
+      if ((timer.elapsed() - lastReport*telemetryInterval) < telemetryInterval) then continue;
+      lastReport += 1;
+
+      const t = timer.elapsed();
+      const tree = + reduce exploredTree;
+      const stats = pool.getLocalStats();
+      const sinceImprovement = timeSinceEpoch().totalSeconds() -
+        incumbent.lastImprovement.read(memoryOrder.relaxed);
+
+      const line = try! ("[telemetry] locale %i | t = %.1dr s | nodes = %i (%.0dr/s) | pool = %i " +
+        "| idle = %i, parked = %i | local steals = %i/%i | global steals = %i/%i " +
+        "| best = %i (%.1dr s ago)").format(here.id, t, tree, (tree - lastTree) / telemetryInterval,
+        stats.size, stats.idleTasks, stats.parkedTasks, stats.localSteals, stats.localStealAttempts,
+        stats.globalSteals, stats.globalStealAttempts, incumbent.read(), sinceImprovement);
+      lastTree = tree;
+
+      if (telemetryFile == "") {
+        writeln(line);
+      }
+      else {
+        try! {
+          var f: file = open(path, ioMode.a);
+          var channel = f.writer(locking=false);
+          channel.writeln(line);
+          channel.close();
+          f.close();
+        }
+      }
+    }
+  }
+}
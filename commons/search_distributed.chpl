@@ -1,23 +1,43 @@
 module search_distributed
 {
-  use List;
+  use IO;
   use Time;
+  use List;
+  use FileSystem;
   use PrivateDist;
   use DistributedBag_DFS;
   use AllLocalesBarriers;
 
   use util;
   use Problem;
-
-  config param activeSetSize: int = 1;
+  use Incumbent;
+  use Telemetry;
+
+  /*
+    Interval between two checkpoints, in seconds (0 disables checkpointing), and
+    prefix of the checkpoint files, one per locale.
+  */
+  config const checkpointInterval: real = 0.0;
+  config const checkpointPath: string = "checkpoint";
+  /*
+    Resume the search from the checkpoint files instead of the root.
+  */
+  config const restart: bool = false;
+
+  private param CKPT_NONE  = 0;
+  private param CKPT_PAUSE = 1;
+
+  proc checkpointFile(const locId: int): string
+  {
+    return checkpointPath + "_" + locId:string + ".bin";
+  }
 
   proc search_distributed(type Node, problem, const saveTime: bool, const activeSet: bool): void
   {
-    // Global variables (best solution found and termination)
-    var best: int = problem.getInitBound();
-    var lockBest: sync bool = true;
-    var eachLocaleState: [PrivateSpace] atomic bool = BUSY;
-    var allLocalesIdleFlag: atomic bool = false;
+    checkChildOrder();
+
+    // Global variables (best solution found, one replica per locale)
+    var incumbents = newReplicatedIncumbent(problem.getInitBound(), problem.isMinimization());
     allLocalesBarrier.reset(here.maxTaskPar); // configuration of the global barrier
 
     // Statistics
@@ -26,7 +46,17 @@ module search_distributed
     var eachMaxDepth: [PrivateSpace] int;
     var globalTimer: stopwatch;
 
+    // Per-task statistics, global so that they can be checkpointed
+    var eachTaskExploredTree: [PrivateSpace] [0..#here.maxTaskPar] int;
+    var eachTaskExploredSol: [PrivateSpace] [0..#here.maxTaskPar] int;
+    var eachTaskMaxDepth: [PrivateSpace] [0..#here.maxTaskPar] int;
+
+    // Checkpointing
+    var ckptState: [PrivateSpace] atomic int = CKPT_NONE;
+    var eachPausedTasks: [PrivateSpace] atomic int;
+
     writeln("Distributed execution mode with ", numLocales, " locales and ", here.maxTaskPar, " tasks each");
+    if (strategy != "dfs") then warning("`strategy` is ignored in distributed mode (depth-first search only)");
     problem.print_settings();
 
     globalTimer.start();
@@ -36,163 +66,280 @@ module search_distributed
     // ===============
 
     var bag = new distBag_DFS(Node, targetLocales = Locales);
+    bag.setMaxDepth(problem.getMaxDepth());
     var root = new Node(problem);
 
-    if activeSet {
+    if restart {
       /*
-        An initial set is sequentially computed and distributed across locales.
+        Each locale reloads its own checkpoint file. The statistics of the previous
+        run are attributed to task 0.
+      */
+      if activeSet then warning("`activeSet` is ignored when restarting");
+
+      coforall loc in Locales with (ref eachTaskExploredTree, ref eachTaskExploredSol,
+        ref eachTaskMaxDepth) do on loc {
+        try! {
+          var f = open(checkpointFile(here.id), ioMode.r);
+          var reader = f.reader(locking=false);
+
+          var savedLocales, best, tree, sol, depth: int;
+          reader.readBinary(savedLocales);
+          if (savedLocales != numLocales) then
+            halt("checkpoint written with ", savedLocales, " locales, restarting with ", numLocales);
+          reader.readBinary(best);
+          reader.readBinary(tree);
+          reader.readBinary(sol);
+          reader.readBinary(depth);
+
+          incumbents[here.id]!.update(best);
+          eachTaskExploredTree[here.id][0] = tree;
+          eachTaskExploredSol[here.id][0] = sol;
+          eachTaskMaxDepth[here.id][0] = depth;
+
+          bag.readLocal(reader);
+
+          reader.close();
+          f.close();
+        }
+      }
+    }
+    else if activeSet {
+      /*
+        An initial set is computed in parallel and distributed across locales.
         We require at least `activeSetSize` elements per task.
       */
       var initSize: int = activeSetSize * here.maxTaskPar * numLocales;
-      var initList: list(Node);
-      initList.pushBack(root);
-      var lockList: sync bool = false;
+      var a = generateActiveSet(Node, problem, root, initSize, eachExploredTree[0],
+        eachExploredSol[0], eachMaxDepth[0], incumbents[0]!);
 
-      ref tree_loc = eachExploredTree[0];
-      ref num_sol = eachExploredSol[0];
-      ref max_depth = eachMaxDepth[0];
+      // Static distribution of the set
+      distributeActiveSet(bag, a);
+
+      // Attribute the statistics of the generation to task 0 of locale 0, so that
+      // they are checkpointed along with the per-task statistics
+      eachTaskExploredTree[0][0] += eachExploredTree[0];
+      eachTaskExploredSol[0][0] += eachExploredSol[0];
+      eachTaskMaxDepth[0][0] = max(eachTaskMaxDepth[0][0], eachMaxDepth[0]);
+      (eachExploredTree[0], eachExploredSol[0], eachMaxDepth[0]) = (0, 0, 0);
+    }
+    else {
+      /*
+        In that case, there is only one node in the bag (task 0 of locale 0).
+      */
+      bag.add(root, 0);
+    }
 
-      coforall taskId in 0..<here.maxTaskPar with (ref tree_loc,
-        ref num_sol, ref max_depth, ref initList, ref lockList, ref best) {
+    /*
+      Write one checkpoint file per locale, in parallel, while no task modifies the
+      bag.
+    */
+    proc writeCheckpointFiles(): void
+    {
+      coforall loc in Locales do on loc {
+        const path = checkpointFile(here.id);
 
-        var best_task: int = best;
-        var tree = tree_loc;
-        var num = num_sol;
-        var max = max_depth;
+        try! {
+          var f = open(path + ".tmp", ioMode.cw);
+          var writer = f.writer(locking=false);
 
-        var parent: Node;
-        while (initList.size < initSize) {
-          if !popBackSafe(initList, lockList, parent) then continue;
+          writer.writeBinary(numLocales);
+          writer.writeBinary(incumbents[here.id]!.read());
+          writer.writeBinary(+ reduce eachTaskExploredTree[here.id]);
+          writer.writeBinary(+ reduce eachTaskExploredSol[here.id]);
+          writer.writeBinary(max reduce eachTaskMaxDepth[here.id]);
 
-          var children = problem.decompose(Node, parent, tree, num,
-            max, best, lockBest, best_task);
+          bag.writeLocal(writer);
 
-          for elt in children do pushFrontSafe(initList, lockList, elt);
-        }
+          writer.close();
+          f.close();
 
-        tree_loc += tree;
-        num_sol += num;
-        max_depth += max;
+          rename(path + ".tmp", path);
+        }
       }
+    }
 
-      // Static distribution of the set
-      var a = initList.toArray();
-      const size = a.size;
-      const r_size = size - (size % numLocales);
+    /*
+      Stop the world and write the checkpoint files (see `writeCheckpointFiles`). It is
+      called by task 0 of locale 0 between two decompositions, while the other tasks
+      pause at the top of their loop. Parked tasks hold no element and cannot be
+      woken up while the others are paused, so they are counted as paused. We give
+      up if termination is detected in the meantime, as there is nothing to save.
+    */
+    proc writeCheckpoint(): void
+    {
+      const numTasks = here.maxTaskPar;
 
-      coforall loc in 0..<numLocales do on Locales[loc] {
-        for i in loc..<r_size by numLocales do
-          bag.add(a[i], 0);
+      coforall loc in Locales with (ref ckptState) do on loc {
+        eachPausedTasks[here.id].waitFor(0);
+        ckptState[here.id].write(CKPT_PAUSE);
+      }
 
-        if (loc == 0) {
-          for i in r_size..<size do
-            bag.add(a[i], 0);
+      var aborted = false;
+      while true {
+        if bag.isTerminated() {
+          aborted = true;
+          break;
         }
+
+        var count: int = 1; // the caller
+        for loc in Locales do on loc {
+          count += eachPausedTasks[here.id].read() + bag.getParkedTasks();
+        }
+        if (count >= numLocales * numTasks) then break;
+
+        currentTask.yieldExecution();
+      }
+
+      if !aborted then writeCheckpointFiles();
+
+      coforall loc in Locales with (ref ckptState) do on loc {
+        ckptState[here.id].write(CKPT_NONE);
       }
-    }
-    else {
-      /*
-        In that case, there is only one node in the bag (task 0 of locale 0).
-      */
-      bag.add(root, 0);
     }
 
     // =====================
     // PARALLEL EXPLORATION
     // =====================
 
-    coforall loc in Locales with (const ref problem, ref eachLocaleState, ref eachExploredTree,
-      ref eachExploredSol, ref eachMaxDepth, ref best) do on loc {
+    var stopped: atomic bool = false;
+
+    coforall loc in Locales with (const ref problem, ref eachExploredTree,
+      ref eachExploredSol, ref eachMaxDepth, ref eachTaskExploredTree, ref eachTaskExploredSol,
+      ref eachTaskMaxDepth, ref eachPausedTasks) do on loc {
 
       const numTasks = here.maxTaskPar;
       var problem_loc = problem.copy();
-
-      // Local variables
-      /* var best_locale: int = best; */
-      var allTasksIdleFlag: atomic bool = false;
-      var eachTaskState: [0..#numTasks] atomic bool = BUSY;
+      const incumbent = incumbents[here.id]!;
 
       // Local statistics
-      var eachLocalExploredTree: [0..#numTasks] int;
-      var eachLocalExploredSol: [0..#numTasks] int;
-      var eachLocalMaxDepth: [0..#numTasks] int;
-
-      coforall taskId in 0..#numTasks with (ref eachLocalExploredTree, ref eachLocalExploredSol,
-        ref eachLocalMaxDepth, ref eachTaskState, ref eachLocaleState, ref best/*, ref best_locale*/) {
-
-        // Task variables
-        var best_task: int = best; //_locale;
-        var taskState, locState: bool = BUSY;
-        var counter: int = 0;
-        ref tree_loc = eachLocalExploredTree[taskId];
-        ref num_sol = eachLocalExploredSol[taskId];
-        ref max_depth = eachLocalMaxDepth[taskId];
-
-        allLocalesBarrier.barrier(); // synchronization barrier
-
-        // Exploration of the tree
-        while true do {
-
-          // Try to remove an element
-          var (hasWork, parent): (int, Node) = bag.remove(taskId);
-
-          /*
-            Check (or not) the termination condition regarding the value of 'hasWork':
-              'hasWork' = -1 : remove() fails              -> check termination
-              'hasWork' =  0 : remove() prematurely fails  -> continue
-              'hasWork' =  1 : remove() succeeds           -> decompose
-          */
-          if (hasWork == 1) {
-            if taskState {
-              taskState = BUSY;
-              eachTaskState[taskId].write(BUSY);
-            }
-            if locState {
-              locState = BUSY;
-              eachLocaleState[here.id].write(BUSY);
-            }
-          }
-          else if (hasWork == 0) {
-            if !taskState {
-              taskState = IDLE;
-              eachTaskState[taskId].write(IDLE);
+      ref eachLocalExploredTree = eachTaskExploredTree[here.id];
+      ref eachLocalExploredSol = eachTaskExploredSol[here.id];
+      ref eachLocalMaxDepth = eachTaskMaxDepth[here.id];
+
+      var explorationDone: atomic bool = false;
+
+      sync {
+        // Progress reports of this locale, in a dedicated task
+        if (telemetryInterval > 0.0) then
+          begin telemetry(bag, eachLocalExploredTree, incumbent, explorationDone);
+
+        // Primal heuristic of the problem, in a dedicated task of locale 0 only, so
+        // that the other locales keep all their cores for the search
+        if ((here.id == 0) && heuristicTask) then
+          begin problem_loc.improveIncumbent(incumbent, explorationDone);
+
+        // Limits of the search, checked by a dedicated task of locale 0
+        if ((here.id == 0) && isLimited()) then begin {
+          while !explorationDone.read() {
+            sleep(limitPollInterval);
+
+            // each locale sums its own counters, so that a check costs one message
+            // per locale, and none without a node limit
+            var tree: atomic int;
+            if (nodeLimit > 0) then
+              coforall loc in Locales with (ref tree) do on loc do
+                tree.add(+ reduce eachTaskExploredTree[here.id]);
+
+            if limitReached(globalTimer.elapsed(), tree.read()) {
+              stopped.write(true);
+              bag.stop();
+              break;
             }
-            continue;
           }
-          else {
-            if !taskState {
-              taskState = IDLE;
-              eachTaskState[taskId].write(IDLE);
-            }
-            if allIdle(eachTaskState, allTasksIdleFlag) {
-              if !locState {
-                locState = IDLE;
-                eachLocaleState[here.id].write(IDLE);
-              }
-              if allIdle(eachLocaleState, allLocalesIdleFlag) {
-                break;
+        }
+
+        coforall taskId in 0..#numTasks with (ref eachLocalExploredTree, ref eachLocalExploredSol,
+          ref eachLocalMaxDepth, ref eachPausedTasks) {
+
+          // Task variables
+          var best_task: int = incumbent.read();
+          var counter: int = 0;
+          ref tree_loc = eachLocalExploredTree[taskId];
+          ref num_sol = eachLocalExploredSol[taskId];
+          ref max_depth = eachLocalMaxDepth[taskId];
+          var children = bag.sink(taskId);
+          var staged: list(Node);
+          var parents: [0..#decomposeBatchSize] Node;
+          const isCoordinator = ((here.id == 0) && (taskId == 0) && (checkpointInterval > 0.0));
+          var ckptTimer: stopwatch;
+          if isCoordinator then ckptTimer.start();
+
+          allLocalesBarrier.barrier(); // synchronization barrier
+
+          // Exploration of the tree
+          while true do {
+
+            // Checkpointing, done between two decompositions
+            if isCoordinator {
+              if (ckptTimer.elapsed() >= checkpointInterval) {
+                writeCheckpoint();
+                ckptTimer.clear();
               }
             }
-            continue;
-          }
-
-          // Decompose an element
-          var children = problem_loc.decompose(Node, parent, tree_loc, num_sol,
-            max_depth, best, lockBest, best_task);
+            else if (ckptState[here.id].read() == CKPT_PAUSE) {
+              eachPausedTasks[here.id].add(1);
+              ckptState[here.id].waitFor(CKPT_NONE);
+              eachPausedTasks[here.id].sub(1);
+            }
 
-          bag.addBulk(children, taskId);
+            // Remove a batch of elements, if the private portion of the segment holds
+            // enough of them, and decompose them at once
+            var n: int = 0;
+            if (decomposeBatchSize > 1) then n = bag.removeBulk(taskId, parents);
+
+            if (n > 0) {
+              // Elements dominated by the best solution found so far are discarded
+              const m = pruneBatch(problem_loc, parents, n, best_task);
+              if (m > 0) then
+                decomposeBatchOrdered(Node, problem_loc, parents, m, children, staged, tree_loc,
+                  num_sol, max_depth, best_task, incumbent);
+            }
+            else {
+              // Try to remove an element
+              var (hasWork, parent): (int, Node) = bag.remove(taskId);
+
+              /*
+                Check (or not) the termination condition regarding the value of 'hasWork':
+                  'hasWork' = -2 : the bag is globally empty and all tasks are idle -> terminate
+                  'hasWork' = -1 : remove() fails                                   -> continue
+                  'hasWork' =  0 : remove() prematurely fails                       -> continue
+                  'hasWork' =  1 : remove() succeeds                                -> decompose
+              */
+              if (hasWork == -2) then break;
+              else if (hasWork != 1) then continue;
+
+              // Discard the element if it is dominated by the best solution found so far
+              if problem_loc.isPruned(parent, best_task) then continue;
+
+              // Explore small subtrees in place, otherwise decompose the element (its
+              // children are directly pushed into the bag)
+              if problem_loc.isSmallSubtree(parent, cutoffDepth) then
+                solveSubtree(Node, problem_loc, parent, bag, children, tree_loc, num_sol, max_depth,
+                  best_task, incumbent);
+              else
+                decomposeOrdered(Node, problem_loc, parent, children, staged, tree_loc, num_sol,
+                  max_depth, best_task, incumbent);
+              n = 1;
+            }
 
-          // Read the best solution found so far
-          /* if (taskId == 0) {
-            counter += 1;
-            if (counter % 10000 == 0) then best_locale = best.read();
+            // Read the best solution found so far
+            counter += n;
+            if (counter >= incumbentPollRate) {
+              counter = 0;
+              incumbent.refresh(best_task);
+            }
           }
 
-          best_task = best_locale; */
-        }
+          // Wait for in-flight broadcasts so that all replicas agree on the best
+          allLocalesBarrier.barrier();
+          incumbent.pending.waitFor(0);
+          allLocalesBarrier.barrier();
 
-        if best_task != best then num_sol = 0;
-      } // end coforall tasks
+          if best_task != incumbent.read() then num_sol = 0;
+        } // end coforall tasks
+
+        explorationDone.write(true);
+      }
 
       eachExploredTree[here.id] += (+ reduce eachLocalExploredTree);
       eachExploredSol[here.id] += (+ reduce eachLocalExploredSol);
@@ -201,6 +348,16 @@ module search_distributed
 
     globalTimer.stop();
 
+    if stopped.read() {
+      print_gap(bag, settleIncumbent(incumbents), problem);
+
+      // Save the unexplored nodes, so that the search can be resumed
+      if (checkpointInterval > 0.0) {
+        writeCheckpointFiles();
+        writeln("Unexplored nodes saved to ", checkpointPath, "_*.bin");
+      }
+    }
+
     // ========
     // OUTPUTS
     // ========
@@ -212,8 +369,10 @@ module search_distributed
       save_time(numLocales, globalTimer.elapsed(), path);
     }
 
-    problem.print_results(eachExploredTree, eachExploredSol, eachMaxDepth, best,
+    problem.print_results(eachExploredTree, eachExploredSol, eachMaxDepth, settleIncumbent(incumbents),
       globalTimer.elapsed());
+
+    deleteReplicatedIncumbent(incumbents);
   }
 
 }
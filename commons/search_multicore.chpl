@@ -1,23 +1,23 @@
 module search_multicore
 {
-  use List;
   use Time;
+  use List;
   use DistributedBag_DFS;
+  use PriorityPool;
 
   use util;
   use Problem;
-
-  config param activeSetSize: int = 1;
+  use Incumbent;
+  use Telemetry;
 
   proc search_multicore(type Node, problem, const saveTime: bool, const activeSet: bool): void
   {
+    checkChildOrder();
+
     const numTasks = here.maxTaskPar;
 
-    // Global variables (best solution found and termination)
-    var best: int = problem.getInitBound();
-    var lockBest: sync bool = true;
-    var allTasksIdleFlag: atomic bool = false;
-    var eachTaskState: [0..#numTasks] atomic bool = BUSY;
+    // Global variables (best solution found)
+    var incumbent = new Incumbent(problem.getInitBound(), problem.isMinimization());
 
     // Statistics
     var eachExploredTree: [0..#numTasks] int;
@@ -30,137 +30,150 @@ module search_multicore
 
     globalTimer.start();
 
-    // ===============
-    // INITIALIZATION
-    // ===============
-
-    var bag = new distBag_DFS(Node);
-    var root = new Node(problem);
-
-    if activeSet {
-      /*
-        An initial set is sequentially computed and distributed across tasks.
-        We require at least `activeSetSize` elements per task.
-      */
-      var initSize: int = activeSetSize * numTasks;
-      var initList: list(Node);
-      initList.pushBack(root);
-      var lockList: sync bool = false;
-
-      ref tree_loc = eachExploredTree[0];
-      ref num_sol = eachExploredSol[0];
-      ref max_depth = eachMaxDepth[0];
-
-      coforall taskId in 0..<numTasks with (ref tree_loc,
-        ref num_sol, ref max_depth, ref initList, ref lockList, ref best) {
-
-        var best_task: int = best;
-        var tree = tree_loc;
-        var num = num_sol;
-        var max = max_depth;
-
-        var parent: Node;
-        while (initList.size < initSize) {
-          if !popBackSafe(initList, lockList, parent) then continue;
+    /*
+      The pool is either a distBag_DFS (depth-first search) or a PriorityPool
+      (best-first and hybrid searches), which share the same interface.
+    */
+    proc explore(const ref bag): void
+    {
+      // ===============
+      // INITIALIZATION
+      // ===============
 
-          var children = problem.decompose(Node, parent, tree, num,
-            max, best, lockBest, best_task);
+      var root = new Node(problem);
+      bag.setMaxDepth(problem.getMaxDepth());
 
-          for elt in children do pushFrontSafe(initList, lockList, elt);
-        }
-
-        tree_loc += tree;
-        num_sol += num;
-        max_depth += max;
-      }
-
-      // Static distribution of the set
-      var a = initList.toArray();
-      const size = a.size;
-      const r_size = size - (size % numTasks);
-
-      coforall taskId in 0..<numTasks {
-        for i in taskId..<r_size by numTasks do
-          bag.add(a[i], taskId);
+      if activeSet {
+        /*
+          An initial set is computed in parallel and distributed across tasks.
+          We require at least `activeSetSize` elements per task.
+        */
+        var initSize: int = activeSetSize * numTasks;
+        var a = generateActiveSet(Node, problem, root, initSize, eachExploredTree[0],
+          eachExploredSol[0], eachMaxDepth[0], incumbent);
 
-        if (taskId == 0) {
-          for i in r_size..<size do
-            bag.add(a[i], taskId);
-        }
+        // Static distribution of the set
+        distributeActiveSet(bag, a, [here]);
       }
-    }
-    else {
-      /*
-        In that case, there is only one node in the bag (task 0 of locale 0).
-      */
-      bag.add(root, 0);
-    }
-
-    // =====================
-    // PARALLEL EXPLORATION
-    // =====================
-
-    coforall taskId in 0..#numTasks with (ref eachExploredTree, ref eachExploredSol,
-      ref eachMaxDepth, ref eachTaskState, ref best) {
-
-      // Task variables
-      var best_task: int = best;
-      var taskState: bool = BUSY;
-      var counter: int = 0;
-      ref tree_loc = eachExploredTree[taskId];
-      ref num_sol = eachExploredSol[taskId];
-      ref max_depth = eachMaxDepth[taskId];
-
-      // Exploration of the tree
-      while true do {
-
-        // Try to remove an element
-        var (hasWork, parent): (int, Node) = bag.remove(taskId);
-
+      else {
         /*
-          Check (or not) the termination condition regarding the value of 'hasWork':
-            'hasWork' = -1 : remove() fails              -> check termination
-            'hasWork' =  0 : remove() prematurely fails  -> continue
-            'hasWork' =  1 : remove() succeeds           -> decompose
+          In that case, there is only one node in the bag (task 0 of locale 0).
         */
-        if (hasWork == 1) {
-          if taskState {
-            taskState = BUSY;
-            eachTaskState[taskId].write(BUSY);
-          }
-        }
-        else if (hasWork == 0) {
-          if !taskState {
-            taskState = IDLE;
-            eachTaskState[taskId].write(IDLE);
+        bag.add(root, 0);
+      }
+
+      // =====================
+      // PARALLEL EXPLORATION
+      // =====================
+
+      var explorationDone: atomic bool = false;
+      var stopped: atomic bool = false;
+
+      sync {
+        // Progress reports, in a dedicated task
+        if (telemetryInterval > 0.0) then
+          begin telemetry(bag, eachExploredTree, incumbent, explorationDone);
+
+        // Primal heuristic of the problem, in a dedicated task
+        if heuristicTask then
+          begin problem.improveIncumbent(incumbent, explorationDone);
+
+        // Limits of the search, checked by a dedicated task
+        if isLimited() then begin {
+          while !explorationDone.read() {
+            sleep(limitPollInterval);
+            const tree = if (nodeLimit > 0) then (+ reduce eachExploredTree) else 0;
+            if limitReached(globalTimer.elapsed(), tree) {
+              stopped.write(true);
+              bag.stop();
+              break;
+            }
           }
-          continue;
         }
-        else {
-          if !taskState {
-            taskState = IDLE;
-            eachTaskState[taskId].write(IDLE);
-          }
-          if allIdle(eachTaskState, allTasksIdleFlag) {
-            break;
+
+        coforall taskId in 0..#numTasks with (ref eachExploredTree, ref eachExploredSol,
+          ref eachMaxDepth) {
+
+          // Task variables
+          var best_task: int = incumbent.read();
+          var counter: int = 0;
+          ref tree_loc = eachExploredTree[taskId];
+          ref num_sol = eachExploredSol[taskId];
+          ref max_depth = eachMaxDepth[taskId];
+          var children = bag.sink(taskId);
+          var staged: list(Node);
+          var parents: [0..#decomposeBatchSize] Node;
+
+          // Exploration of the tree
+          while true do {
+
+            // Remove a batch of elements, if the private portion of the segment holds
+            // enough of them, and decompose them at once
+            var n: int = 0;
+            if (decomposeBatchSize > 1) then n = bag.removeBulk(taskId, parents);
+
+            if (n > 0) {
+              // Elements dominated by the best solution found so far are discarded
+              const m = pruneBatch(problem, parents, n, best_task);
+              if (m > 0) then
+                decomposeBatchOrdered(Node, problem, parents, m, children, staged, tree_loc,
+                  num_sol, max_depth, best_task, incumbent);
+            }
+            else {
+              // Try to remove an element
+              var (hasWork, parent): (int, Node) = bag.remove(taskId);
+
+              /*
+                Check (or not) the termination condition regarding the value of 'hasWork':
+                  'hasWork' = -2 : the bag is empty and all tasks are idle -> terminate
+                  'hasWork' = -1 : remove() fails                          -> continue
+                  'hasWork' =  0 : remove() prematurely fails              -> continue
+                  'hasWork' =  1 : remove() succeeds                       -> decompose
+              */
+              if (hasWork == -2) then break;
+              else if (hasWork != 1) then continue;
+
+              // Discard the element if it is dominated by the best solution found so far
+              if problem.isPruned(parent, best_task) then continue;
+
+              // Explore small subtrees in place, otherwise decompose the element (its
+              // children are directly pushed into the bag)
+              if problem.isSmallSubtree(parent, cutoffDepth) then
+                solveSubtree(Node, problem, parent, bag, children, tree_loc, num_sol, max_depth,
+                  best_task, incumbent);
+              else
+                decomposeOrdered(Node, problem, parent, children, staged, tree_loc, num_sol,
+                  max_depth, best_task, incumbent);
+              n = 1;
+            }
+
+            // Read the best solution found so far
+            counter += n;
+            if (counter >= incumbentPollRate) {
+              counter = 0;
+              incumbent.refresh(best_task);
+            }
           }
-          continue;
+
+          if best_task != incumbent.read() then num_sol = 0;
         }
 
-        // Decompose an element
-        var children = problem.decompose(Node, parent, tree_loc, num_sol,
-          max_depth, best, lockBest, best_task);
+        explorationDone.write(true);
+      }
 
-        bag.addBulk(children, taskId);
+      if stopped.read() then print_gap(bag, incumbent.read(), problem);
+    }
 
-        // Read the best solution found so far
-        /* if (taskId == 0) {
-          counter += 1;
-          if (counter % 10000 == 0) then best_task = best.read();
-        } */
+    select strategy {
+      when "dfs" {
+        explore(new distBag_DFS(Node));
+      }
+      when "best", "hybrid" {
+        explore(new PriorityPool(Node, problem, strategy == "hybrid"));
+      }
+      otherwise {
+        halt("unknown search strategy");
       }
-
-      if best_task != best then num_sol = 0;
     }
 
     globalTimer.stop();
@@ -176,7 +189,7 @@ module search_multicore
       save_time(numTasks, globalTimer.elapsed(), path);
     }
 
-    problem.print_results(eachExploredTree, eachExploredSol, eachMaxDepth, best,
+    problem.print_results(eachExploredTree, eachExploredSol, eachMaxDepth, incumbent.read(),
       globalTimer.elapsed());
   }
 }
@@ -3,14 +3,19 @@ module search_sequential
   use List;
   use Time;
 
+  use PriorityPool;
+
   use util;
   use Problem;
+  use Incumbent;
 
   proc search_sequential(type Node, problem, const saveTime: bool): void
   {
+    checkChildOrder();
+
     var best: int = problem.getInitBound();
-    /* Not needed in sequential mode, but we use it only to match the generic template. */
-    var lockBest: sync bool = true;
+    // Best solution found so far, updated by the decomposition along with `best`
+    var incumbent = new Incumbent(best, problem.isMinimization());
 
     // Statistics
     var exploredTree: int;
@@ -27,26 +32,83 @@ module search_sequential
     // INITIALIZATION
     // ===============
 
-    var pool: list(Node);
     var root = new Node(problem);
-
-    pool.pushBack(root);
+    const limited = isLimited();
+    var stopped = false;
 
     // ============
     // EXPLORATION
     // ============
 
-    // Exploration of the tree
-    while !pool.isEmpty() do {
-
-      // Remove an element
-      var parent: Node = pool.popBack();
-
-      // Decompose the element
-      var children = problem.decompose(Node, parent, exploredTree, exploredSol,
-        maxDepth, best, lockBest, best);
-
-      pool.pushBack(children);
+    select strategy {
+      when "dfs" {
+        var pool: list(Node);
+        var parents: [0..#decomposeBatchSize] Node;
+        var staged: list(Node);
+        pool.pushBack(root);
+
+        // Exploration of the tree
+        while !pool.isEmpty() do {
+
+          // Stop if a limit is reached
+          if (limited && limitReached(globalTimer.elapsed(), exploredTree)) {
+            stopped = true;
+            break;
+          }
+
+          // Remove a batch of elements and decompose them at once
+          if ((decomposeBatchSize > 1) && (pool.size >= decomposeBatchSize)) {
+            for i in 0..#decomposeBatchSize do parents[i] = pool.popBack();
+
+            // Elements dominated by the best solution found so far are discarded
+            const m = pruneBatch(problem, parents, decomposeBatchSize, best);
+            if (m > 0) then
+              decomposeBatchOrdered(Node, problem, parents, m, pool, staged, exploredTree,
+                exploredSol, maxDepth, best, incumbent);
+            continue;
+          }
+
+          // Remove an element
+          var parent: Node = pool.popBack();
+          if problem.isPruned(parent, best) then continue;
+
+          // Decompose the element (its children are directly pushed into the pool)
+          decomposeOrdered(Node, problem, parent, pool, staged, exploredTree, exploredSol,
+            maxDepth, best, incumbent);
+        }
+
+        if stopped then print_gap(pool, best, problem);
+      }
+      when "best", "hybrid" {
+        var pool = new PriorityPool(Node, problem, strategy == "hybrid",
+          numTasks = 1);
+        pool.add(root, 0);
+        var children = pool.sink(0);
+
+        // Exploration of the tree
+        while true do {
+
+          // Stop if a limit is reached
+          if (limited && limitReached(globalTimer.elapsed(), exploredTree)) {
+            stopped = true;
+            break;
+          }
+
+          // Remove an element (fails only when the pool is empty)
+          var (hasWork, parent): (int, Node) = pool.remove(0);
+          if (hasWork != 1) then break;
+          if problem.isPruned(parent, best) then continue;
+
+          // Decompose the element (its children are directly pushed into the pool)
+          problem.decompose(Node, parent, children, exploredTree, exploredSol,
+            maxDepth, best, incumbent);
+        }
+
+        if stopped then print_gap(pool, best, problem);
+      }
+      otherwise {
+        halt("unknown search strategy");
+      }
     }
 
     globalTimer.stop();
@@ -2,44 +2,104 @@ module util
 {
   use IO;
   use List;
+  use Incumbent only incumbentPollRate;
 
-  param BUSY: bool = false;
-  param IDLE: bool = true;
+  /*
+    Minimum number of elements per task in the initial set (see `--activeSet`).
+  */
+  config const activeSetSize: int = 1;
+
+  /*
+    Search strategy: "dfs" (depth-first), "best" (best-first, falling back to
+    depth-first beyond a memory cap) or "hybrid" (depth-first with periodic
+    best-first restarts). See the PriorityPool module.
+  */
+  config const strategy: string = "dfs";
+
+  /*
+    Number of elements removed and decomposed at once by a task, when the private
+    portion of its pool holds enough of them (1 disables batching).
+  */
+  config const decomposeBatchSize: int = 1;
+
+  /*
+    Number of levels above the leaves from which the subtree of a removed node is
+    explored in place by the task, on a private stack, without going through the
+    pool (0 disables the cutoff). See `Problem.isSmallSubtree`.
+  */
+  config const cutoffDepth: int = 0;
+
+  /*
+    Order in which the children of a node are inserted in the pool, the last one
+    being explored first in depth-first search: "none" (order of generation),
+    "bound" (most promising bound explored first) or "problem" (smallest
+    `Problem.childKey` explored first).
+  */
+  config const childOrder: string = "none";
 
-  // Take a boolean array and return false if it contains at least one "true", "true" if not
-  inline proc all_idle(const arr: [] atomic bool): bool
+  proc checkChildOrder(): void
   {
-    for elt in arr {
-      if (elt.read() == BUSY) then return false;
+    select childOrder {
+      when "none", "bound", "problem" {}
+      otherwise {
+        halt("unknown child order");
+      }
     }
-
-    return true;
   }
 
   /*
-    REMARK: This function is supposed to be called only when the flag is 'false',
-    so there is no need to set it when the check is 'false'.
+    Run the primal heuristic of the problem, if any, in a dedicated task of locale
+    0 during the search (see `Problem.improveIncumbent`). It runs alongside the
+    search tasks, so that one core of locale 0 is oversubscribed.
+  */
+  config const heuristicTask: bool = false;
+
+  /*
+    Limits of the search, in seconds and explored nodes (0 means no limit). When
+    one is reached, all the tasks stop and the gap is reported.
   */
-  proc check_and_set(const arr: [] atomic bool, flag: atomic bool): bool
+  config const timeLimit: real = 0.0;
+  config const nodeLimit: int = 0;
+
+  /*
+    Seconds between two checks of the limits. In distributed mode, each check of
+    `nodeLimit` costs one message per locale.
+  */
+  config const limitPollInterval: real = 0.1;
+
+  inline proc isLimited(): bool
   {
-    // if all tasks are empty...
-    if all_idle(arr) {
-      // set the flag
-      flag.write(true);
-      return true;
-    }
-    else {
-      return false;
-    }
+    return ((timeLimit > 0.0) || (nodeLimit > 0));
+  }
+
+  inline proc limitReached(const elapsedTime: real, const exploredTree: int): bool
+  {
+    return (((nodeLimit > 0) && (exploredTree >= nodeLimit)) ||
+      ((timeLimit > 0.0) && (elapsedTime >= timeLimit)));
   }
 
-  proc allIdle(const arr: [] atomic bool, flag: atomic bool): bool
+  /*
+    Print the number of nodes left in `pool` when the search is stopped by a limit,
+    their best bound and the resulting optimality gap with respect to `best`.
+  */
+  proc print_gap(const ref pool, const best: int, problem): void
   {
-    if flag.read() {
-      return true;
+    const minimize = problem.isMinimization();
+    var remaining: int;
+    var bound: int = if minimize then max(int) else min(int);
+
+    for elt in pool {
+      remaining += 1;
+      bound = if minimize then min(bound, problem.getBound(elt)) else max(bound, problem.getBound(elt));
     }
-    else {
-      return check_and_set(arr, flag);
+
+    writeln("\nSearch stopped by a limit, ", remaining, " nodes left unexplored.");
+
+    if (remaining > 0) {
+      const diff = if minimize then (best - bound) else (bound - best);
+      const gap = 100.0 * max(0, diff) / max(1, abs(best));
+      writeln("Best bound of the unexplored nodes: ", bound);
+      writeln("Optimality gap: ", gap, "%");
     }
   }
 
@@ -60,25 +120,211 @@ module util
     writeln("\n  General Parameters:\n");
     writeln("   --mode           str    parallel execution mode (sequential, multicore, distributed)");
     writeln("   --activeSet      bool   compute and distribute an initial set of elements");
+    writeln("   --activeSetSize  int    minimum number of elements per task in the initial set");
+    writeln("   --strategy       str    search strategy (dfs, best, hybrid)");
+    writeln("   --decomposeBatchSize int number of elements decomposed at once by a task");
+    writeln("   --cutoffDepth    int    levels above the leaves from which subtrees are explored in place");
+    writeln("   --childOrder     str    order of exploration of the children (none, bound, problem)");
+    writeln("   --heuristicTask  bool   improve the best solution with the problem's heuristic during the search");
+    writeln("   --timeLimit      real   stop the search after this many seconds (0 for no limit)");
+    writeln("   --nodeLimit      int    stop the search after this many explored nodes (0 for no limit)");
+    writeln("   --limitPollInterval real   seconds between two checks of the limits");
     writeln("   --saveTime       bool   save processing time in a file");
+    writeln("   --telemetryInterval real   seconds between two progress reports, 0 to disable");
+    writeln("   --telemetryFile  str    prefix of the report files, standard output if empty");
+    writeln("   --checkpointInterval real  seconds between two checkpoints, 0 to disable (distributed mode)");
+    writeln("   --checkpointPath str    prefix of the checkpoint files (distributed mode)");
+    writeln("   --restart        bool   resume from the checkpoint files (distributed mode)");
     writeln("   --help (or -h)          print this message");
   }
 
-  proc pushFrontSafe(ref L: list(?), lockList: sync, elt) {
-    lockList.readFE(); // acquire
-    L.insert(0, elt);
-    lockList.writeEF(false); // release
+  /*
+    Compute an initial set of at least `initSize` elements (unless the tree is
+    smaller), by expanding the frontier one level at a time in parallel. Each
+    node of a level writes its children into its own buffer, and the buffers are
+    concatenated in order once the level is done, so that no lock is involved.
+  */
+  proc generateActiveSet(type Node, problem, const root: Node, const initSize: int,
+    ref tree_loc: int, ref num_sol: int, ref max_depth: int, incumbent)
+  {
+    var frontierDom = {0..0};
+    var frontier: [frontierDom] Node = root;
+
+    while ((frontierDom.size > 0) && (frontierDom.size < initSize)) {
+      var buffers: [frontierDom] list(Node);
+
+      forall i in frontierDom with (+ reduce tree_loc, + reduce num_sol,
+        max reduce max_depth, ref buffers) {
+        var best_task: int = incumbent.read();
+        problem.decompose(Node, frontier[i], buffers[i], tree_loc, num_sol,
+          max_depth, best_task, incumbent);
+      }
+
+      // Concatenation of the buffers
+      const sizes = [b in buffers] b.size;
+      const offsets = (+ scan sizes) - sizes;
+      const nextDom = {0..#(+ reduce sizes)};
+      var next: [nextDom] Node;
+
+      forall i in frontierDom with (ref next) {
+        for (elt, j) in zip(buffers[i], offsets[i]..) do next[j] = elt;
+      }
+
+      frontierDom = nextDom;
+      frontier = next;
+    }
+
+    return frontier;
   }
 
-  proc popBackSafe(ref L: list(?), lockList: sync, inout elt): bool {
-    lockList.readFE();
-    if L.size > 0 {
-      elt = L.popBack();
-      lockList.writeEF(false);
-      return true;
-    } else {
-      lockList.writeEF(false);
-      return false;
+  /*
+    Discard the elements of `parents[0..#n]` dominated by `best` (see
+    `Problem.isPruned`), keeping the others in order at the front. Return their
+    number.
+  */
+  proc pruneBatch(problem, ref parents: [] ?Node, const n: int, const best: int): int
+  {
+    var m = 0;
+    for i in 0..#n {
+      if !problem.isPruned(parents[i], best) {
+        if (m != i) then parents[m] = parents[i];
+        m += 1;
+      }
+    }
+
+    return m;
+  }
+
+  /*
+    Priority of a child for `childOrder`: the lower, the earlier it is explored.
+  */
+  inline proc childPriority(problem, const child): int
+  {
+    if (childOrder == "problem") then return problem.childKey(child);
+    return if problem.isMinimization() then problem.getBound(child) else -problem.getBound(child);
+  }
+
+  /*
+    Insert the children gathered in `staged` into `children`, from the least to
+    the most promising one (see `childOrder`), and empty `staged`. Children are
+    few, so that an insertion sort is used, which keeps ties in generation order.
+  */
+  proc emitOrdered(problem, ref staged: list(?Node), ref children): void
+  {
+    for i in 1..<staged.size {
+      const child = staged[i];
+      const key = childPriority(problem, child);
+      var j = i;
+      while ((j > 0) && (childPriority(problem, staged[j-1]) < key)) {
+        staged[j] = staged[j-1];
+        j -= 1;
+      }
+      staged[j] = child;
+    }
+
+    for child in staged do children.pushBack(child);
+    staged.clear();
+  }
+
+  /*
+    Decompose `parent` into `children`, going through `staged` to reorder the
+    children if required (see `childOrder`).
+  */
+  proc decomposeOrdered(type Node, problem, const parent: Node, ref children,
+    ref staged: list(Node), ref tree_loc: int, ref num_sol: int, ref max_depth: int,
+    ref best_task: int, incumbent): void
+  {
+    if (childOrder == "none") {
+      problem.decompose(Node, parent, children, tree_loc, num_sol, max_depth, best_task, incumbent);
+    }
+    else {
+      problem.decompose(Node, parent, staged, tree_loc, num_sol, max_depth, best_task, incumbent);
+      emitOrdered(problem, staged, children);
+    }
+  }
+
+  /*
+    Same as `decomposeOrdered`, for the `nParents` first elements of `parents`.
+  */
+  proc decomposeBatchOrdered(type Node, problem, const parents: [] Node, const nParents: int,
+    ref children, ref staged: list(Node), ref tree_loc: int, ref num_sol: int,
+    ref max_depth: int, ref best_task: int, incumbent): void
+  {
+    if (childOrder == "none") {
+      problem.decomposeBatch(Node, parents, nParents, children, tree_loc, num_sol,
+        max_depth, best_task, incumbent);
+    }
+    else {
+      problem.decomposeBatch(Node, parents, nParents, staged, tree_loc, num_sol,
+        max_depth, best_task, incumbent);
+      emitOrdered(problem, staged, children);
+    }
+  }
+
+  /*
+    Explore the subtree rooted at `root` depth-first on a private stack: the nodes
+    are neither inserted in the pool nor visible to the thieves (see `cutoffDepth`).
+    As in the main loop of the engines, the best solution is read every
+    `incumbentPollRate` nodes; if `pool` has been stopped meanwhile, the rest of
+    the subtree is handed back to it through `children`.
+  */
+  proc solveSubtree(type Node, problem, const root: Node, const ref pool, ref children,
+    ref tree_loc: int, ref num_sol: int, ref max_depth: int, ref best_task: int, incumbent): void
+  {
+    var stack, staged: list(Node);
+    var counter: int = 0;
+    stack.pushBack(root);
+
+    while !stack.isEmpty() {
+      const node = stack.popBack();
+      if problem.isPruned(node, best_task) then continue;
+      decomposeOrdered(Node, problem, node, stack, staged, tree_loc, num_sol, max_depth,
+        best_task, incumbent);
+
+      counter += 1;
+      if (counter >= incumbentPollRate) {
+        counter = 0;
+        incumbent.refresh(best_task);
+
+        // the search may have been stopped by a limit (see `print_gap`)
+        if pool.isTerminated() {
+          for elt in stack do children.pushBack(elt);
+          return;
+        }
+      }
+    }
+  }
+
+  /*
+    Distribute the initial set `a` (indexed from 0) across the segments of `bag`.
+    Elements are dealt round-robin to the locales, then to the tasks of each locale.
+    The share of each locale is first made contiguous, so that it is shipped with
+    a single bulk transfer, and each segment is filled with a single insertion.
+  */
+  proc distributeActiveSet(const ref bag, const ref a: [] ?eltType,
+    const targetLocales: [] locale = Locales): void
+  {
+    const size = a.size;
+    const numLocs = targetLocales.size;
+    const q = size / numLocs, r = size % numLocs;
+
+    // the share of locale 'locId' starts at 'locId*q + min(locId, r)'
+    var sorted: [0..#size] eltType;
+    forall i in 0..#size with (ref sorted) {
+      const locId = i % numLocs;
+      sorted[locId*q + min(locId, r) + i / numLocs] = a[i];
+    }
+
+    coforall (loc, locId) in zip(targetLocales, 0..) do on loc {
+      const count = q + (if (locId < r) then 1 else 0);
+      const share: [0..#count] eltType = sorted[(locId*q + min(locId, r))..#count];
+      const numTasks = here.maxTaskPar;
+
+      coforall taskId in 0..#numTasks {
+        const n = (count - taskId + numTasks - 1) / numTasks;
+        const elts: [0..#n] eltType = share[taskId..<count by numTasks];
+        bag.addBulk(elts, taskId);
+      }
     }
   }
 }
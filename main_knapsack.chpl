@@ -29,9 +29,23 @@ module main_knapsack
   config const s: c_int  = 100;
 
   proc main(args: [] string): int
+  {
+    /*
+      The upper bound is a compile-time parameter of the problem, so that the search
+      is instantiated for each of them.
+    */
+    select upperBoundId(ub) {
+      when DANTZIG do return run(DANTZIG, args);
+      when MARTELLO do return run(MARTELLO, args);
+    }
+
+    halt("DEADCODE");
+  }
+
+  proc run(param ubId: int, args: [] string): int
   {
     // Initialization of the problem
-    var knapsack = new Problem_Knapsack(inst, n, r, t, id, s, ub, lb);
+    var knapsack = new Problem_Knapsack(ubId, inst, n, r, t, id, s, lb);
 
     // Helper
     for a in args[1..] {
@@ -19,12 +19,39 @@ module main_pfsp
   config const inst: string = "ta14"; // instance's name
   config const lb: string   = "lb1";  // lb1, lb1_d, lb2
   config const br: string   = "fwd";  // fwd, bwd, alt, maxSum, minMin, minBranch
-  config const ub: string   = "opt";  // opt, inf
+  config const ub: string   = "opt";  // opt, inf, heur
+  config const igIter: int  = 1000;   // iterated greedy steps of the 'heur' upper bound
 
   proc main(args: [] string): int
+  {
+    /*
+      The lower bound and the branching rule are compile-time parameters of the
+      problem, so that the search is instantiated for each of them.
+    */
+    const (lbId, brId) = pfspVariant(lb, br);
+
+    select lbId {
+      when LB1 do return run(LB1, FWD, args);
+      when LB2 do return run(LB2, FWD, args);
+      when LB1_D {
+        select brId {
+          when FWD do return run(LB1_D, FWD, args);
+          when BWD do return run(LB1_D, BWD, args);
+          when ALT do return run(LB1_D, ALT, args);
+          when MAXSUM do return run(LB1_D, MAXSUM, args);
+          when MINMIN do return run(LB1_D, MINMIN, args);
+          when MINBRANCH do return run(LB1_D, MINBRANCH, args);
+        }
+      }
+    }
+
+    halt("DEADCODE");
+  }
+
+  proc run(param lbId: int, param brId: int, args: [] string): int
   {
     // Initialization of the problem
-    var pfsp = new Problem_PFSP(inst, lb, br, ub);
+    var pfsp = new Problem_PFSP(lbId, brId, inst, ub, igIter);
 
     // Helper
     for a in args[1..] {
@@ -22,9 +22,23 @@ module main_qap
   config const lb: string     = "glb"; // glb, hhb
 
   proc main(args: [] string): int
+  {
+    /*
+      The lower bound is a compile-time parameter of the problem, so that the search
+      is instantiated for each of them.
+    */
+    select lowerBoundId(lb) {
+      when GLB do return run(GLB, args);
+      when HHB do return run(HHB, args);
+    }
+
+    halt("DEADCODE");
+  }
+
+  proc run(param lbId: int, args: [] string): int
   {
     // Initialization of the problem
-    var qap = new Problem_QAP(inst, itmax, lb, ub);
+    var qap = new Problem_QAP(lbId, inst, itmax, ub);
 
     // Helper
     for a in args[1..] {
@@ -0,0 +1,58 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+source ./instances_pfsp.sh
+
+tests=(
+  "ta003"
+  "ta004"
+  "ta007"
+  "ta011"
+  "ta014"
+)
+
+# Branching rules to test (lb1_d only)
+brs=("fwd" "bwd" "alt" "maxSum" "minMin" "minBranch")
+
+for inst in "${tests[@]}"; do
+  expected="${instances[$inst]}"
+
+  for br in "${brs[@]}"; do
+    echo "======================================"
+    echo "Instance=$inst LB=lb1_d BR=$br (expected=$expected)"
+
+    cmd="../main_pfsp.out --mode sequential --inst $inst --lb lb1_d --br $br --ub opt"
+
+    # Run solver with timeout protection
+    if ! output=$(timeout 60s $cmd); then
+      echo "FAIL (timeout or crash)"
+      exit 1
+    fi
+
+    # Extract optimal makespan from solver output
+    result=$(echo "$output" \
+      | grep -i "optimal makespan" \
+      | sed -E 's/.*makespan: ([0-9]+).*/\1/')
+
+    # Validate parsing
+    if [ -z "$result" ]; then
+      echo "FAIL (could not parse makespan)"
+      exit 1
+    fi
+
+    if ! [[ "$result" =~ ^[0-9]+$ ]]; then
+      echo "FAIL (invalid makespan: $result)"
+      exit 1
+    fi
+
+    # Check correctness against expected optimum
+    if [ "$result" -ne "$expected" ]; then
+      echo "FAIL (expected $expected, got $result)"
+      exit 1
+    fi
+
+    echo "PASS"
+  done
+done
+
+echo "All PFSP tests with the branching rules passed!"
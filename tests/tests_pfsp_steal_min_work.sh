@@ -0,0 +1,58 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+source ./instances_pfsp.sh
+
+tests=(
+  "ta003"
+  "ta004"
+  "ta007"
+  "ta011"
+  "ta014"
+)
+
+# Minimum remaining work of a single steal (see distributedBagStealMinWork)
+minWorks=("3" "8")
+
+for inst in "${tests[@]}"; do
+  expected="${instances[$inst]}"
+
+  for minWork in "${minWorks[@]}"; do
+    echo "======================================"
+    echo "Instance=$inst LB=lb1_d StealMinWork=$minWork (expected=$expected)"
+
+    cmd="../main_pfsp.out --mode multicore --inst $inst --lb lb1_d --ub opt --distributedBagStealMinWork $minWork"
+
+    # Run solver with timeout protection (also catches termination hangs)
+    if ! output=$(timeout 60s $cmd); then
+      echo "FAIL (timeout or crash)"
+      exit 1
+    fi
+
+    # Extract optimal makespan from solver output
+    result=$(echo "$output" \
+      | grep -i "optimal makespan" \
+      | sed -E 's/.*makespan: ([0-9]+).*/\1/')
+
+    # Validate parsing
+    if [ -z "$result" ]; then
+      echo "FAIL (could not parse makespan)"
+      exit 1
+    fi
+
+    if ! [[ "$result" =~ ^[0-9]+$ ]]; then
+      echo "FAIL (invalid makespan: $result)"
+      exit 1
+    fi
+
+    # Check correctness against expected optimum
+    if [ "$result" -ne "$expected" ]; then
+      echo "FAIL (expected $expected, got $result)"
+      exit 1
+    fi
+
+    echo "PASS"
+  done
+done
+
+echo "All PFSP tests with a steal minimum work passed!"